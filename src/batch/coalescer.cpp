@@ -0,0 +1,160 @@
+#include "coalescer.h"
+#include "../fft/fft.h"
+#include "../profile/trace.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// Requests can share a dispatch chain when every shader constant would match
+static bool sameGroup(const TransformOptions& a, const TransformOptions& b) {
+    return a.forceDft == b.forceDft && a.normalization == b.normalization && a.dftPrecision == b.dftPrecision
+        && a.workgroupX == b.workgroupX && a.workgroupY == b.workgroupY;
+}
+
+RequestCoalescer::RequestCoalescer(WebGPUContext& context, std::chrono::microseconds window, int maxBatch)
+    : context(context), window(window), maxBatch(std::max(maxBatch, 1)) {
+    WGPUSupportedLimits limits = {};
+    wgpuDeviceGetLimits(context.device, &limits);
+    maxBindingBytes = limits.limits.maxStorageBufferBindingSize;
+    scheduler = std::thread([this]() { schedulerLoop(); });
+}
+
+RequestCoalescer::~RequestCoalescer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    scheduler.join();
+    if (bufferBytes > 0) {
+        releaseBuffer(context, inputBuffer);
+        releaseBuffer(context, outputBuffer);
+    }
+}
+
+std::future<void> RequestCoalescer::submit(
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    Request request = {output, input, rows, cols, doInverse, options, std::chrono::steady_clock::now(), {}};
+    std::future<void> done = request.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(request));
+        ++counts.requests;
+    }
+    wake.notify_all();
+    return done;
+}
+
+void RequestCoalescer::transform(
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    submit(output, input, rows, cols, doInverse, options).get();
+}
+
+CoalescerStats RequestCoalescer::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counts;
+}
+
+// Largest group for a request's shape: maxBatch, cut so the whole batch fits one storage binding
+size_t RequestCoalescer::groupLimit(const Request& request) const {
+    const uint64_t matrixBytes = complexElementSize(StorageFormat::Float32) * uint64_t(request.rows) * uint64_t(request.cols);
+    return size_t(std::max<uint64_t>(1, std::min<uint64_t>(uint64_t(maxBatch), maxBindingBytes / matrixBytes)));
+}
+
+void RequestCoalescer::schedulerLoop() {
+    auto matches = [](const Request& a, const Request& b) {
+        return a.rows == b.rows && a.cols == b.cols && a.doInverse == b.doInverse && sameGroup(a.options, b.options);
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return;
+        }
+
+        // The oldest request sets the deadline; a full group, or shutdown, runs it early
+        const size_t limit = groupLimit(pending.front());
+        wake.wait_until(lock, pending.front().arrival + window, [&]() {
+            return stopping || size_t(std::count_if(pending.begin(), pending.end(), [&](const Request& request) {
+                return matches(request, pending.front());
+            })) >= limit;
+        });
+
+        std::vector<Request> group;
+        group.push_back(std::move(pending.front()));
+        pending.pop_front();
+        for (auto request = pending.begin(); request != pending.end() && group.size() < limit;) {
+            if (matches(*request, group.front())) {
+                group.push_back(std::move(*request));
+                request = pending.erase(request);
+            } else {
+                ++request;
+            }
+        }
+        ++counts.batches;
+        counts.largestBatch = std::max(counts.largestBatch, int(group.size()));
+
+        lock.unlock();
+        runGroup(group);
+        lock.lock();
+    }
+}
+
+// Uploads each request into its slot of one buffer, transforms the batch and scatters the readback
+void RequestCoalescer::runGroup(std::vector<Request>& group) {
+    TRACE_SCOPE("coalesced batch");
+    const Request& first = group.front();
+    const size_t total = size_t(first.rows) * size_t(first.cols);
+    const size_t matrixBytes = complexElementSize(StorageFormat::Float32) * total;
+    const uint64_t bytes = uint64_t(group.size()) * matrixBytes;
+    TransformOptions options = first.options;
+    options.storage = StorageFormat::Float32;
+
+    try {
+        if (bytes > bufferBytes) {
+            if (bufferBytes > 0) {
+                releaseBuffer(context, inputBuffer);
+                releaseBuffer(context, outputBuffer);
+            }
+            const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst);
+            inputBuffer = createBuffer(context, nullptr, bytes, usage);
+            outputBuffer = createBuffer(context, nullptr, bytes, usage);
+            bufferBytes = bytes;
+        }
+
+        for (size_t index = 0; index < group.size(); ++index) {
+            writeBuffer(context, inputBuffer, index * matrixBytes, group[index].input, matrixBytes);
+        }
+        fftBatched(context, outputBuffer, inputBuffer, int(group.size()), first.rows, first.cols, first.doInverse, options);
+        const bool mapped = readBackMapped(context, bytes, outputBuffer, [&](const void* data, size_t) {
+            const unsigned char* results = static_cast<const unsigned char*>(data);
+            for (size_t index = 0; index < group.size(); ++index) {
+                std::memcpy(static_cast<void*>(group[index].output), results + index * matrixBytes, matrixBytes);
+            }
+        });
+        if (!mapped) {
+            throw std::runtime_error("readback of a coalesced batch failed");
+        }
+    } catch (...) {
+        for (Request& request : group) {
+            request.done.set_exception(std::current_exception());
+        }
+        return;
+    }
+    for (Request& request : group) {
+        request.done.set_value();
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef COALESCER_H
+#define COALESCER_H
+
+#include <chrono>
+#include <complex>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../webgpu_utils.h"
+#include "../transform_options.h"
+
+// Requests and batches handled by a RequestCoalescer so far
+struct CoalescerStats {
+    uint64_t requests = 0;
+    uint64_t batches = 0;
+    int largestBatch = 0;
+};
+
+// Dynamic batching in front of the GPU transform. Callers on any thread submit host matrices; a
+// scheduler thread holds each request for up to `window`, groups the pending requests by shape,
+// direction and options, and runs each group as one fftBatched dispatch chain. Each request is
+// uploaded into its slot of one shared input buffer, and the whole group comes back in a single
+// readback whose results are copied to each caller's output. This trades at most `window` of
+// extra latency for far fewer dispatches when many small same-shape transforms arrive together.
+// The coalescer owns the context's queue while it runs: nothing else may use `context` until it is
+// destroyed. GPU work uses f32 storage.
+class RequestCoalescer {
+public:
+    // Groups are cut at `maxBatch` requests and at the device's storage binding limit
+    RequestCoalescer(WebGPUContext& context, std::chrono::microseconds window, int maxBatch = 64);
+    ~RequestCoalescer();
+
+    RequestCoalescer(const RequestCoalescer&) = delete;
+    RequestCoalescer& operator=(const RequestCoalescer&) = delete;
+
+    // Queues a transform; the future becomes ready once `output` holds the result, or carries the
+    // exception the transform threw. Both pointers must stay valid until then.
+    std::future<void> submit(
+        std::complex<float>* output,
+        const std::complex<float>* input,
+        int rows,
+        int cols,
+        uint32_t doInverse,
+        const TransformOptions& options = {}
+    );
+
+    // submit() and wait
+    void transform(
+        std::complex<float>* output,
+        const std::complex<float>* input,
+        int rows,
+        int cols,
+        uint32_t doInverse,
+        const TransformOptions& options = {}
+    );
+
+    CoalescerStats stats();
+
+private:
+    struct Request {
+        std::complex<float>* output;
+        const std::complex<float>* input;
+        int rows;
+        int cols;
+        uint32_t doInverse;
+        TransformOptions options;
+        std::chrono::steady_clock::time_point arrival;
+        std::promise<void> done;
+    };
+
+    void schedulerLoop();
+    size_t groupLimit(const Request& request) const;
+    void runGroup(std::vector<Request>& group);
+
+    WebGPUContext& context;
+    const std::chrono::microseconds window;
+    const int maxBatch;
+    uint64_t maxBindingBytes = 0;
+
+    // Reused between groups and grown to the largest group so far; only the scheduler thread touches them
+    wgpu::Buffer inputBuffer = nullptr;
+    wgpu::Buffer outputBuffer = nullptr;
+    uint64_t bufferBytes = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> pending;
+    CoalescerStats counts;
+    bool stopping = false;
+    std::thread scheduler;
+};
+
+#endif // COALESCER_H
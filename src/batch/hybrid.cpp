@@ -0,0 +1,130 @@
+#include "hybrid.h"
+#include "../stream/stream.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Transforms timed per engine when a shape is first seen; the first GPU round also compiles pipelines
+static const int probeTransforms = 4;
+
+// Weight of the latest batch when refining a rate
+static const double rateSmoothing = 0.5;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Streams `count` matrices starting at `input` through the GPU into `output` (which may be null to discard)
+static double runGpuShare(
+    WebGPUContext& gpu,
+    int slots,
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int count,
+    bool repeatFirst,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    const size_t total = size_t(rows) * size_t(cols);
+    const Clock::time_point start = Clock::now();
+    runStream(gpu, rows, cols, doInverse, options, count, slots,
+        [&](int frame) -> const void* {
+            return input + (repeatFirst ? 0 : size_t(frame) * total);
+        },
+        [&](int frame, const void* data, size_t bytes) {
+            if (output) {
+                std::memcpy(static_cast<void*>(output + size_t(frame) * total), data, bytes);
+            }
+        });
+    return secondsSince(start);
+}
+
+// Measures both engines on the first matrix of the batch without touching the output
+static HybridRates probeRates(
+    WebGPUContext& gpu,
+    CpuContext& cpu,
+    int slots,
+    const std::complex<float>* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    HybridRates rates;
+    runGpuShare(gpu, slots, nullptr, input, probeTransforms, true, rows, cols, doInverse, options);
+    rates.gpuMs = 1e3 * runGpuShare(gpu, slots, nullptr, input, probeTransforms, true, rows, cols, doInverse, options) / probeTransforms;
+
+    std::vector<std::complex<float>> scratch(size_t(rows) * size_t(cols));
+    const Clock::time_point start = Clock::now();
+    for (int probe = 0; probe < probeTransforms; ++probe) {
+        cpuFft(cpu, scratch.data(), input, rows, cols, doInverse, options);
+    }
+    rates.cpuMs = 1e3 * secondsSince(start) / probeTransforms;
+    return rates;
+}
+
+HybridStats runHybridBatch(
+    WebGPUContext& gpu,
+    CpuContext& cpu,
+    HybridScheduler& scheduler,
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    HybridStats stats;
+    if (batch <= 0) {
+        return stats;
+    }
+    TransformOptions gpuOptions = options;
+    gpuOptions.storage = StorageFormat::Float32;
+    const size_t total = size_t(rows) * size_t(cols);
+    const int slots = std::max(scheduler.gpuSlots, 1);
+
+    const std::string key = std::to_string(rows) + "x" + std::to_string(cols) + (doInverse ? " inverse" : " forward");
+    auto found = scheduler.rates.find(key);
+    if (found == scheduler.rates.end()) {
+        found = scheduler.rates.emplace(key, probeRates(gpu, cpu, slots, input, rows, cols, doInverse, gpuOptions)).first;
+    }
+    HybridRates& rates = found->second;
+
+    // Both sides should finish together: the GPU takes cpuMs / (gpuMs + cpuMs) of the batch
+    const double gpuFraction = rates.gpuMs + rates.cpuMs > 0.0 ? rates.cpuMs / (rates.gpuMs + rates.cpuMs) : 1.0;
+    stats.gpuTransforms = std::min(batch, std::max(0, int(std::lround(gpuFraction * batch))));
+    stats.cpuTransforms = batch - stats.gpuTransforms;
+
+    const Clock::time_point start = Clock::now();
+    std::thread cpuWorker([&]() {
+        const Clock::time_point cpuStart = Clock::now();
+        for (int index = stats.gpuTransforms; index < batch; ++index) {
+            cpuFft(cpu, output + size_t(index) * total, input + size_t(index) * total, rows, cols, doInverse, options);
+        }
+        stats.cpuSeconds = secondsSince(cpuStart);
+    });
+    if (stats.gpuTransforms > 0) {
+        stats.gpuSeconds = runGpuShare(gpu, slots, output, input, stats.gpuTransforms, false, rows, cols, doInverse, gpuOptions);
+    }
+    cpuWorker.join();
+
+    stats.seconds = secondsSince(start);
+    stats.transformsPerSecond = stats.seconds > 0.0 ? batch / stats.seconds : 0.0;
+
+    // Refine the rates with what this batch measured, so the next split tracks contention and clocks
+    if (stats.gpuTransforms > 0) {
+        rates.gpuMs += rateSmoothing * (1e3 * stats.gpuSeconds / stats.gpuTransforms - rates.gpuMs);
+    }
+    if (stats.cpuTransforms > 0) {
+        rates.cpuMs += rateSmoothing * (1e3 * stats.cpuSeconds / stats.cpuTransforms - rates.cpuMs);
+    }
+    return stats;
+}
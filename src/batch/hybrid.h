@@ -0,0 +1,52 @@
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include <complex>
+#include <map>
+#include <string>
+#include "../cpu/cpu_fft.h"
+#include "../webgpu_utils.h"
+#include "../transform_options.h"
+
+// Measured cost of one transform on each engine for a shape and direction
+struct HybridRates {
+    double gpuMs = 0.0;
+    double cpuMs = 0.0;
+};
+
+// Carries per-shape rates between batches so each split reflects what the previous batch measured
+struct HybridScheduler {
+    std::map<std::string, HybridRates> rates;
+    int gpuSlots = 3; // in-flight GPU frames, as in runStream
+};
+
+// How one batch was split and how long each side took
+struct HybridStats {
+    int gpuTransforms = 0;
+    int cpuTransforms = 0;
+    double gpuSeconds = 0.0;
+    double cpuSeconds = 0.0;
+    double seconds = 0.0;
+    double transformsPerSecond = 0.0;
+};
+
+// Transforms `batch` contiguous rows x cols complex64 matrices from `input` into `output`. The batch is
+// split in proportion to each engine's measured throughput: the first part is streamed through the GPU
+// from the calling thread while a second thread runs the rest on the CPU engine, and both write straight
+// into `output`. The first batch of a shape is preceded by a short probe of both engines. The GPU share
+// always uses f32 storage so the two halves match. Leave one hardware thread out of `cpu` for the thread
+// driving the GPU.
+HybridStats runHybridBatch(
+    WebGPUContext& gpu,
+    CpuContext& cpu,
+    HybridScheduler& scheduler,
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+);
+
+#endif // HYBRID_H
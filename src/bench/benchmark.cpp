@@ -0,0 +1,275 @@
+#define WEBGPU_CPP_IMPLEMENTATION
+#include "../fft/fft.h"
+#include "../webgpu_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// In-process benchmark harness: sweeps shapes, directions and engines on one device, separating
+// the cold first call (shader compilation and pipeline creation) from steady-state execution.
+//
+//   wgpu_dft_bench --sizes=256,512x300 --directions=forward,inverse --engines=fft,dft
+//                  --warmup=3 --repeats=20 --storage=f32 --format=json --output=results.json
+
+namespace {
+
+struct Shape {
+    int rows;
+    int cols;
+};
+
+struct BenchmarkArgs {
+    vector<Shape> shapes = {{256, 256}, {512, 512}, {1024, 1024}};
+    vector<uint32_t> directions = {0, 1};
+    vector<bool> forceDft = {false};
+    StorageFormat storage = StorageFormat::Float32;
+    int warmup = 3;
+    int repeats = 20;
+    string format = "json";
+    string outputPath; // stdout when empty
+};
+
+struct CaseResult {
+    Shape shape;
+    uint32_t doInverse;
+    bool usesDft;   // the engine that ran: forced, or the fallback for non-power-of-2 shapes
+    double coldMs;  // first call on an empty pipeline cache, waited to completion
+    double planMs;  // cold call minus the steady-state median: shader and pipeline creation
+    double meanMs;
+    double minMs;
+    double maxMs;
+    double p50Ms;
+    double p90Ms;
+    double p99Ms;
+    double gflops;
+    double gbPerSecond;
+};
+
+vector<string> splitList(const string& text) {
+    vector<string> items;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// "512" is square, "300x500" is rows x cols
+Shape parseShape(const string& text) {
+    const size_t separator = text.find('x');
+    if (separator == string::npos) {
+        const int size = stoi(text);
+        return {size, size};
+    }
+    return {stoi(text.substr(0, separator)), stoi(text.substr(separator + 1))};
+}
+
+BenchmarkArgs parseArgs(int argc, char* argv[]) {
+    BenchmarkArgs args;
+    for (int index = 1; index < argc; ++index) {
+        const string arg(argv[index]);
+        const size_t equals = arg.find('=');
+        const string key = arg.substr(0, equals);
+        const string value = equals == string::npos ? "" : arg.substr(equals + 1);
+
+        if (key == "--sizes") {
+            args.shapes.clear();
+            for (const string& item : splitList(value)) {
+                args.shapes.push_back(parseShape(item));
+            }
+        } else if (key == "--directions") {
+            args.directions.clear();
+            for (const string& item : splitList(value)) {
+                args.directions.push_back(item == "forward" ? 0 : 1);
+            }
+        } else if (key == "--engines") {
+            args.forceDft.clear();
+            for (const string& item : splitList(value)) {
+                args.forceDft.push_back(item == "dft");
+            }
+        } else if (key == "--storage") {
+            args.storage = value == "f16" ? StorageFormat::Float16 : StorageFormat::Float32;
+        } else if (key == "--warmup") {
+            args.warmup = stoi(value);
+        } else if (key == "--repeats") {
+            args.repeats = max(stoi(value), 1);
+        } else if (key == "--format") {
+            args.format = value;
+        } else if (key == "--output") {
+            args.outputPath = value;
+        } else {
+            cerr << "Unknown argument " << arg << endl;
+        }
+    }
+    return args;
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const vector<double>& sorted, double fraction) {
+    const size_t rank = size_t(ceil(fraction * sorted.size()));
+    return sorted[min(max(rank, size_t(1)), sorted.size()) - 1];
+}
+
+double timeTransformMs(WebGPUContext& context, wgpu::Buffer& output, wgpu::Buffer& input, Shape shape, uint32_t doInverse, const TransformOptions& options) {
+    const size_t total = size_t(shape.rows) * size_t(shape.cols);
+    const auto start = chrono::steady_clock::now();
+    fft(context, output, input, total, shape.rows, shape.cols, doInverse, options);
+    waitForQueueIdle(context.device, context.queue);
+    const auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+CaseResult runCase(WebGPUContext& context, const BenchmarkArgs& args, Shape shape, uint32_t doInverse, bool forceDft) {
+    TransformOptions options;
+    options.forceDft = forceDft;
+    options.storage = args.storage;
+
+    const size_t total = size_t(shape.rows) * size_t(shape.cols);
+    const size_t bytes = complexElementSize(options.storage) * total;
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+
+    // Random input in the storage format; only the byte pattern matters for timing
+    mt19937 generator(1234);
+    uniform_int_distribution<uint32_t> distribution(0, 0x3BFF); // finite positive halves / small floats
+    vector<uint32_t> data((bytes + 3) / 4);
+    for (uint32_t& word : data) {
+        word = distribution(generator) | (distribution(generator) << 16);
+        if (options.storage == StorageFormat::Float32) {
+            word = 0x3F000000u | (word & 0x007FFFFFu); // floats in [0.5, 1)
+        }
+    }
+    wgpu::Buffer input = createBuffer(context, data.data(), bytes, usage);
+    wgpu::Buffer output = createBuffer(context, nullptr, bytes, usage);
+
+    CaseResult result = {};
+    result.shape = shape;
+    result.doInverse = doInverse;
+    result.usesDft = forceDft || !isValidFFTDimensions(shape.rows, shape.cols);
+
+    clearPipelineCache(context);
+    result.coldMs = timeTransformMs(context, output, input, shape, doInverse, options);
+    for (int iteration = 0; iteration < args.warmup; ++iteration) {
+        timeTransformMs(context, output, input, shape, doInverse, options);
+    }
+    vector<double> samples;
+    for (int iteration = 0; iteration < args.repeats; ++iteration) {
+        samples.push_back(timeTransformMs(context, output, input, shape, doInverse, options));
+    }
+    releaseBuffer(context, input);
+    releaseBuffer(context, output);
+
+    sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result.meanMs = sum / samples.size();
+    result.minMs = samples.front();
+    result.maxMs = samples.back();
+    result.p50Ms = percentile(samples, 0.50);
+    result.p90Ms = percentile(samples, 0.90);
+    result.p99Ms = percentile(samples, 0.99);
+    result.planMs = max(result.coldMs - result.p50Ms, 0.0);
+
+    // Throughput uses the usual 5 N log2 N flop count for a complex FFT of N points, for both
+    // engines, and the minimum traffic of reading the input and writing the output once
+    const double seconds = result.p50Ms * 1e-3;
+    if (seconds > 0.0) {
+        result.gflops = 5.0 * double(total) * log2(double(total)) / seconds * 1e-9;
+        result.gbPerSecond = 2.0 * double(bytes) / seconds * 1e-9;
+    }
+    return result;
+}
+
+void writeJson(ostream& out, const string& adapterName, const BenchmarkArgs& args, const vector<CaseResult>& results) {
+    out << "{\n";
+    out << "  \"adapter\": \"" << adapterName << "\",\n";
+    out << "  \"storage\": \"" << (args.storage == StorageFormat::Float16 ? "f16" : "f32") << "\",\n";
+    out << "  \"warmup\": " << args.warmup << ",\n";
+    out << "  \"repeats\": " << args.repeats << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t index = 0; index < results.size(); ++index) {
+        const CaseResult& r = results[index];
+        out << "    {\"rows\": " << r.shape.rows << ", \"cols\": " << r.shape.cols
+            << ", \"direction\": \"" << (r.doInverse ? "inverse" : "forward") << "\""
+            << ", \"engine\": \"" << (r.usesDft ? "dft" : "fft") << "\""
+            << ", \"cold_ms\": " << r.coldMs << ", \"plan_ms\": " << r.planMs
+            << ", \"mean_ms\": " << r.meanMs << ", \"min_ms\": " << r.minMs << ", \"max_ms\": " << r.maxMs
+            << ", \"p50_ms\": " << r.p50Ms << ", \"p90_ms\": " << r.p90Ms << ", \"p99_ms\": " << r.p99Ms
+            << ", \"gflops\": " << r.gflops << ", \"gb_per_s\": " << r.gbPerSecond << "}"
+            << (index + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+void writeCsv(ostream& out, const vector<CaseResult>& results) {
+    out << "rows,cols,direction,engine,cold_ms,plan_ms,mean_ms,min_ms,max_ms,p50_ms,p90_ms,p99_ms,gflops,gb_per_s\n";
+    for (const CaseResult& r : results) {
+        out << r.shape.rows << "," << r.shape.cols << ","
+            << (r.doInverse ? "inverse" : "forward") << "," << (r.usesDft ? "dft" : "fft") << ","
+            << r.coldMs << "," << r.planMs << "," << r.meanMs << "," << r.minMs << "," << r.maxMs << ","
+            << r.p50Ms << "," << r.p90Ms << "," << r.p99Ms << "," << r.gflops << "," << r.gbPerSecond << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const BenchmarkArgs args = parseArgs(argc, argv);
+
+    WebGPUContext context;
+    if (!initWebGPU(context)) {
+        cerr << "No usable WebGPU device; the benchmark needs one" << endl;
+        releaseWebGPU(context);
+        return -1;
+    }
+    if (args.storage == StorageFormat::Float16 && !context.supportsF16) {
+        cerr << "shader-f16 is not supported by this adapter" << endl;
+        releaseWebGPU(context);
+        return -1;
+    }
+
+    const string adapterName = context.adapterName;
+
+    vector<CaseResult> results;
+    for (const Shape& shape : args.shapes) {
+        for (bool forceDft : args.forceDft) {
+            for (uint32_t doInverse : args.directions) {
+                results.push_back(runCase(context, args, shape, doInverse, forceDft));
+                cerr << shape.rows << "x" << shape.cols << " " << (results.back().usesDft ? "dft" : "fft") << " "
+                     << (doInverse ? "inverse" : "forward") << " p50 " << results.back().p50Ms << " ms" << endl;
+            }
+        }
+    }
+
+    ofstream file;
+    if (!args.outputPath.empty()) {
+        file.open(args.outputPath);
+        if (!file) {
+            cerr << "Failed to open " << args.outputPath << endl;
+            releaseWebGPU(context);
+            return -1;
+        }
+    }
+    ostream& out = args.outputPath.empty() ? cout : file;
+    if (args.format == "csv") {
+        writeCsv(out, results);
+    } else {
+        writeJson(out, adapterName, args, results);
+    }
+
+    releaseWebGPU(context);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "result_cache.h"
+#include "../fft/fft.h"
+#include "../profile/trace.h"
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+// Multiply-xorshift mixing, as in the finalizers of MurmurHash3 and splitmix64
+static uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+std::string hashContents(const void* data, size_t bytes) {
+    const unsigned char* input = static_cast<const unsigned char*>(data);
+    uint64_t first = 0x9e3779b97f4a7c15ull ^ bytes;
+    uint64_t second = 0x632be59bd9b4e019ull + bytes;
+    size_t offset = 0;
+    for (; offset + sizeof(uint64_t) <= bytes; offset += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, input + offset, sizeof(word));
+        first = (first ^ word) * 0x87c37b91114253d5ull;
+        first = (first << 31) | (first >> 33);
+        second = (second + word) * 0x4cf5ad432745937full;
+        second ^= second >> 29;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, input + offset, bytes - offset);
+    first = mix(first ^ tail);
+    second = mix(second + tail + first);
+
+    std::ostringstream hex;
+    hex << std::hex << std::setfill('0') << std::setw(16) << first << std::setw(16) << second;
+    return hex.str();
+}
+
+// Everything that changes the result besides the contents; wisdom only changes how it is computed
+static std::string resultKey(const std::string& contents, int rows, int cols, uint32_t doInverse, const TransformOptions& options) {
+    std::ostringstream key;
+    key << contents << ' ' << rows << 'x' << cols << ' ' << doInverse
+        << ' ' << int(options.storage) << ' ' << int(options.normalization)
+        << ' ' << options.forceDft << ' ' << int(options.dftPrecision)
+        << ' ' << options.workgroupX << 'x' << options.workgroupY;
+    return key.str();
+}
+
+static void copyResult(WebGPUContext& context, wgpu::Buffer& source, wgpu::Buffer& destination, uint64_t bytes) {
+    wgpu::CommandEncoder encoder = context.device.createCommandEncoder();
+    encodeBufferCopy(context, encoder, "cached result copy", source, destination, bytes);
+    wgpu::CommandBuffer commandBuffer = encoder.finish();
+    submitCommandBuffer(context, commandBuffer);
+    commandBuffer.release();
+    encoder.release();
+}
+
+static void evictOldest(WebGPUContext& context, ResultCache& cache) {
+    CachedResult& oldest = cache.entries.back();
+    cache.bytes -= oldest.bytes;
+    cache.index.erase(oldest.key);
+    releaseBuffer(context, oldest.buffer);
+    cache.entries.pop_back();
+    cache.stats.evictions++;
+}
+
+bool fftCached(
+    WebGPUContext& context,
+    ResultCache& cache,
+    wgpu::Buffer& outputBuffer,
+    const void* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("fft cached");
+    const size_t total = size_t(rows) * size_t(cols);
+    const uint64_t bytes = complexElementSize(options.storage) * total;
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+
+    std::string key;
+    if (cache.budgetBytes >= bytes) {
+        key = resultKey(hashContents(input, size_t(bytes)), rows, cols, doInverse, options);
+        auto found = cache.index.find(key);
+        if (found != cache.index.end()) {
+            cache.entries.splice(cache.entries.begin(), cache.entries, found->second);
+            copyResult(context, found->second->buffer, outputBuffer, bytes);
+            cache.stats.hits++;
+            return true;
+        }
+    }
+    cache.stats.misses++;
+
+    wgpu::Buffer inputBuffer = createBuffer(context, input, bytes, usage);
+    if (key.empty()) {
+        fft(context, outputBuffer, inputBuffer, total, rows, cols, doInverse, options);
+        releaseBuffer(context, inputBuffer);
+        return false;
+    }
+
+    while (!cache.entries.empty() && cache.bytes + bytes > cache.budgetBytes) {
+        evictOldest(context, cache);
+    }
+    CachedResult result = {key, createBuffer(context, nullptr, bytes, usage), bytes};
+    fft(context, result.buffer, inputBuffer, total, rows, cols, doInverse, options);
+    releaseBuffer(context, inputBuffer);
+    copyResult(context, result.buffer, outputBuffer, bytes);
+
+    cache.entries.push_front(result);
+    cache.index[key] = cache.entries.begin();
+    cache.bytes += bytes;
+    return false;
+}
+
+void clearResultCache(WebGPUContext& context, ResultCache& cache) {
+    while (!cache.entries.empty()) {
+        CachedResult& oldest = cache.entries.back();
+        releaseBuffer(context, oldest.buffer);
+        cache.entries.pop_back();
+    }
+    cache.index.clear();
+    cache.bytes = 0;
+}
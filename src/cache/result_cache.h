@@ -0,0 +1,57 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "../webgpu_utils.h"
+#include "../transform_options.h"
+
+// One transformed result kept on the device
+struct CachedResult {
+    std::string key;
+    wgpu::Buffer buffer = nullptr;
+    uint64_t bytes = 0;
+};
+
+struct ResultCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+// Device-resident transform results keyed by input contents, shape, direction and engine options,
+// evicted least recently used first once they exceed `budgetBytes`. A budget of 0 disables caching.
+struct ResultCache {
+    uint64_t budgetBytes = 0;
+    uint64_t bytes = 0;
+    std::list<CachedResult> entries; // most recently used first
+    std::unordered_map<std::string, std::list<CachedResult>::iterator> index;
+    ResultCacheStats stats;
+};
+
+// 128-bit hash of a byte range (two independent 64-bit lanes) as 32 hex digits. Reads 8-byte words,
+// so it runs at memory speed; not cryptographic.
+std::string hashContents(const void* data, size_t bytes);
+
+// Transforms the host matrix `input`, given in the storage format, into outputBuffer like fft(). When
+// the same contents were transformed before with the same shape, direction and options, the cached
+// device result is copied to outputBuffer on the GPU instead, with no upload or transform. Misses are
+// transformed into a new cached buffer, evicting older results to stay within budget; results larger
+// than the whole budget bypass the cache. Returns true on a hit.
+bool fftCached(
+    WebGPUContext& context,
+    ResultCache& cache,
+    wgpu::Buffer& outputBuffer,
+    const void* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Releases every cached buffer; the statistics are kept
+void clearResultCache(WebGPUContext& context, ResultCache& cache);
+
+#endif // RESULT_CACHE_H
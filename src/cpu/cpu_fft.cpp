@@ -0,0 +1,237 @@
+#include "cpu_fft.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using Complex = std::complex<float>;
+
+// Columns gathered per block in the column pass: 16 complex64 values fill four 64-byte cache lines per row
+static const int columnBlock = 16;
+
+// Precomputed tables for transforms of one length and direction
+struct LinePlan {
+    int length = 0;
+    bool radix4 = false; // power of 2 and not forced to the DFT
+    bool inverse = false;
+    std::vector<uint32_t> bitReverse;
+    bool leadingRadix2 = false; // odd log2: one radix-2 stage before the radix-4 stages
+    // Per radix-4 stage of quarter length L: w^k, w^2k and w^3k for k < L, each contiguous
+    std::vector<Complex> stageTwiddles;
+    // Direct DFT: exp(-+2 pi i j / n) for j < n
+    std::vector<std::complex<double>> dftTwiddles;
+};
+
+static bool isPowerOfTwo(int n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+static LinePlan makeLinePlan(int length, bool inverse, bool forceDft) {
+    const double pi = std::acos(-1.0);
+    const double sign = inverse ? 1.0 : -1.0;
+    LinePlan plan;
+    plan.length = length;
+    plan.inverse = inverse;
+    plan.radix4 = isPowerOfTwo(length) && !forceDft;
+
+    if (!plan.radix4) {
+        plan.dftTwiddles.resize(length);
+        for (int j = 0; j < length; ++j) {
+            plan.dftTwiddles[j] = std::polar(1.0, sign * 2.0 * pi * j / length);
+        }
+        return plan;
+    }
+
+    int log2Length = 0;
+    while ((1 << log2Length) < length) {
+        ++log2Length;
+    }
+    plan.bitReverse.resize(length);
+    for (int index = 0; index < length; ++index) {
+        uint32_t reversed = 0;
+        for (int bit = 0; bit < log2Length; ++bit) {
+            reversed |= ((uint32_t(index) >> bit) & 1u) << (log2Length - 1 - bit);
+        }
+        plan.bitReverse[index] = reversed;
+    }
+
+    plan.leadingRadix2 = log2Length % 2 == 1;
+    for (int quarter = plan.leadingRadix2 ? 2 : 1; 4 * quarter <= length; quarter *= 4) {
+        for (int power = 1; power <= 3; ++power) {
+            for (int k = 0; k < quarter; ++k) {
+                const std::complex<double> twiddle = std::polar(1.0, sign * 2.0 * pi * power * k / (4.0 * quarter));
+                plan.stageTwiddles.push_back(Complex(float(twiddle.real()), float(twiddle.imag())));
+            }
+        }
+    }
+    return plan;
+}
+
+// Plain complex product; std::complex's operator* adds NaN/inf recovery that blocks vectorization
+static inline Complex multiply(Complex a, Complex b) {
+    return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+// Combines four bit-reversed sub-transforms of length L at `data` into one of length 4L. After the
+// radix-2 bit reversal the blocks hold the inputs congruent to 0, 2, 1 and 3 mod 4.
+static void radix4Block(Complex* data, int quarter, const Complex* w1, const Complex* w2, const Complex* w3, bool inverse) {
+    int k = 0;
+#if defined(__AVX2__)
+    // Four complex values per register; (re, im) pairs multiply with moveldup/movehdup and addsub
+    auto complexMultiply = [](__m256 a, __m256 b) {
+        const __m256 real = _mm256_moveldup_ps(b);
+        const __m256 imag = _mm256_movehdup_ps(b);
+        const __m256 swapped = _mm256_permute_ps(a, 0xB1);
+        return _mm256_addsub_ps(_mm256_mul_ps(a, real), _mm256_mul_ps(swapped, imag));
+    };
+    // Rotation by -i (forward) maps (re, im) to (im, -re); by +i (inverse) to (-im, re)
+    const __m256 rotationSign = inverse
+        ? _mm256_set_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f)
+        : _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+    float* base = reinterpret_cast<float*>(data);
+    for (; k + 4 <= quarter; k += 4) {
+        float* p0 = base + 2 * k;
+        float* p1 = base + 2 * (k + quarter);
+        float* p2 = base + 2 * (k + 2 * quarter);
+        float* p3 = base + 2 * (k + 3 * quarter);
+        const __m256 x0 = _mm256_loadu_ps(p0);
+        const __m256 x2 = complexMultiply(_mm256_loadu_ps(p1), _mm256_loadu_ps(reinterpret_cast<const float*>(w2 + k)));
+        const __m256 x1 = complexMultiply(_mm256_loadu_ps(p2), _mm256_loadu_ps(reinterpret_cast<const float*>(w1 + k)));
+        const __m256 x3 = complexMultiply(_mm256_loadu_ps(p3), _mm256_loadu_ps(reinterpret_cast<const float*>(w3 + k)));
+        const __m256 sum02 = _mm256_add_ps(x0, x2);
+        const __m256 difference02 = _mm256_sub_ps(x0, x2);
+        const __m256 sum13 = _mm256_add_ps(x1, x3);
+        const __m256 rotated = _mm256_xor_ps(_mm256_permute_ps(_mm256_sub_ps(x1, x3), 0xB1), rotationSign);
+        _mm256_storeu_ps(p0, _mm256_add_ps(sum02, sum13));
+        _mm256_storeu_ps(p1, _mm256_add_ps(difference02, rotated));
+        _mm256_storeu_ps(p2, _mm256_sub_ps(sum02, sum13));
+        _mm256_storeu_ps(p3, _mm256_sub_ps(difference02, rotated));
+    }
+#endif
+    for (; k < quarter; ++k) {
+        const Complex x0 = data[k];
+        const Complex x2 = multiply(data[k + quarter], w2[k]);
+        const Complex x1 = multiply(data[k + 2 * quarter], w1[k]);
+        const Complex x3 = multiply(data[k + 3 * quarter], w3[k]);
+        const Complex sum02 = x0 + x2;
+        const Complex difference02 = x0 - x2;
+        const Complex sum13 = x1 + x3;
+        const Complex difference13 = x1 - x3;
+        const Complex rotated = inverse ? Complex(-difference13.imag(), difference13.real())
+                                        : Complex(difference13.imag(), -difference13.real());
+        data[k] = sum02 + sum13;
+        data[k + quarter] = difference02 + rotated;
+        data[k + 2 * quarter] = sum02 - sum13;
+        data[k + 3 * quarter] = difference02 - rotated;
+    }
+}
+
+// Transforms one contiguous line in place; `scratch` holds at least plan.length values
+static void transformLine(const LinePlan& plan, Complex* data, Complex* scratch) {
+    const int length = plan.length;
+    if (!plan.radix4) {
+        // Exact integer phase reduction and double accumulation, like the compensated GPU DFT
+        for (int k = 0; k < length; ++k) {
+            std::complex<double> sum = 0.0;
+            int phase = 0;
+            for (int j = 0; j < length; ++j) {
+                const std::complex<double> twiddle = plan.dftTwiddles[phase];
+                sum += std::complex<double>(
+                    data[j].real() * twiddle.real() - data[j].imag() * twiddle.imag(),
+                    data[j].real() * twiddle.imag() + data[j].imag() * twiddle.real());
+                phase += k;
+                if (phase >= length) {
+                    phase -= length;
+                }
+            }
+            scratch[k] = Complex(float(sum.real()), float(sum.imag()));
+        }
+        std::copy(scratch, scratch + length, data);
+        return;
+    }
+
+    for (int index = 0; index < length; ++index) {
+        const int reversed = int(plan.bitReverse[index]);
+        if (reversed > index) {
+            std::swap(data[index], data[reversed]);
+        }
+    }
+    if (plan.leadingRadix2) {
+        for (int index = 0; index < length; index += 2) {
+            const Complex even = data[index];
+            const Complex odd = data[index + 1];
+            data[index] = even + odd;
+            data[index + 1] = even - odd;
+        }
+    }
+    const Complex* twiddles = plan.stageTwiddles.data();
+    for (int quarter = plan.leadingRadix2 ? 2 : 1; 4 * quarter <= length; quarter *= 4) {
+        for (int base = 0; base < length; base += 4 * quarter) {
+            radix4Block(data + base, quarter, twiddles, twiddles + quarter, twiddles + 2 * quarter, plan.inverse);
+        }
+        twiddles += 3 * quarter;
+    }
+}
+
+void initCpu(CpuContext& context, unsigned threads) {
+    context.pool.reset(new ThreadPool(threads));
+}
+
+void cpuFft(
+    CpuContext& context,
+    Complex* output,
+    const Complex* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    if (!context.pool) {
+        initCpu(context);
+    }
+    ThreadPool& pool = *context.pool;
+    const LinePlan rowPlan = makeLinePlan(cols, doInverse != 0, options.forceDft);
+    const LinePlan colPlan = makeLinePlan(rows, doInverse != 0, options.forceDft);
+    const float scale = float(normalizationScale(options.normalization, doInverse != 0, rows, cols));
+
+    // Per-thread scratch: one line for the DFT, plus a gathered column block
+    std::vector<std::vector<Complex>> lineScratch(pool.size(), std::vector<Complex>(std::max(rows, cols)));
+    std::vector<std::vector<Complex>> blockScratch(pool.size(), std::vector<Complex>(size_t(columnBlock) * rows));
+
+    // ROW PASS: rows are contiguous, so each is copied into the output and transformed there
+    pool.parallelFor(size_t(rows), [&](size_t row, unsigned worker) {
+        Complex* line = output + row * cols;
+        if (input != output) {
+            std::memcpy(static_cast<void*>(line), input + row * cols, sizeof(Complex) * cols);
+        }
+        transformLine(rowPlan, line, lineScratch[worker].data());
+    });
+
+    // COLUMN PASS: a block of adjacent columns is gathered into contiguous lines, transformed and
+    // scattered back with the normalization applied, so every strided access touches full cache lines
+    const size_t blocks = (size_t(cols) + columnBlock - 1) / columnBlock;
+    pool.parallelFor(blocks, [&](size_t block, unsigned worker) {
+        const int firstCol = int(block) * columnBlock;
+        const int width = std::min(columnBlock, cols - firstCol);
+        Complex* gathered = blockScratch[worker].data();
+        for (int row = 0; row < rows; ++row) {
+            const Complex* source = output + size_t(row) * cols + firstCol;
+            for (int col = 0; col < width; ++col) {
+                gathered[size_t(col) * rows + row] = source[col];
+            }
+        }
+        for (int col = 0; col < width; ++col) {
+            transformLine(colPlan, gathered + size_t(col) * rows, lineScratch[worker].data());
+        }
+        for (int row = 0; row < rows; ++row) {
+            Complex* destination = output + size_t(row) * cols + firstCol;
+            for (int col = 0; col < width; ++col) {
+                destination[col] = gathered[size_t(col) * rows + row] * scale;
+            }
+        }
+    });
+}
@@ -0,0 +1,32 @@
+#ifndef CPU_FFT_H
+#define CPU_FFT_H
+
+#include <complex>
+#include <memory>
+#include "../transform_options.h"
+#include "thread_pool.h"
+
+// Host-side state of the CPU engine, the counterpart of WebGPUContext
+struct CpuContext {
+    std::unique_ptr<ThreadPool> pool;
+};
+
+// Starts the worker threads; 0 uses one per hardware thread
+void initCpu(CpuContext& context, unsigned threads = 0);
+
+// CPU engine with the same shape as fft(), on complex64 host memory (input and output may alias).
+// Power-of-2 lengths use radix-4 stages (plus one radix-2 stage for odd log2), vectorized with AVX2
+// when the build enables it; other lengths, or options.forceDft, use a direct DFT accumulated in double.
+// Rows are transformed in place, columns in cache-sized blocks of adjacent columns, both spread over
+// the thread pool. Storage format and workgroup options do not apply.
+void cpuFft(
+    CpuContext& context,
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+);
+
+#endif // CPU_FFT_H
@@ -0,0 +1,77 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    for (unsigned worker = 1; worker < threads; ++worker) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return unsigned(workers.size()) + 1;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t index, unsigned worker)>& body) {
+    if (workers.empty() || count <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            body(index, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->body = &body;
+        this->count = count;
+        next = 0;
+        active = unsigned(workers.size());
+        ++generation;
+    }
+    wake.notify_all();
+    runIndices(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return active == 0; });
+    this->body = nullptr;
+}
+
+// Indices are claimed one at a time, so uneven work (e.g. a ragged last block) balances itself
+void ThreadPool::runIndices(unsigned worker) {
+    for (size_t index = next.fetch_add(1); index < count; index = next.fetch_add(1)) {
+        (*body)(index, worker);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        runIndices(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0) {
+                done.notify_one();
+            }
+        }
+    }
+}
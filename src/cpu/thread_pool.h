@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads kept alive between transforms. The calling thread takes part in
+// every parallelFor as worker 0, so a pool of size 1 runs everything inline.
+class ThreadPool {
+public:
+    // `threads` counts the caller; 0 uses std::thread::hardware_concurrency
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that run work, including the caller
+    unsigned size() const;
+
+    // Calls body(index, worker) for every index in [0, count) and returns once all calls finish.
+    // `worker` is below size(), so callers can index per-thread scratch with it.
+    void parallelFor(size_t count, const std::function<void(size_t index, unsigned worker)>& body);
+
+private:
+    void workerLoop(unsigned worker);
+    void runIndices(unsigned worker);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t, unsigned)>* body = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    unsigned active = 0; // workers still running the current job
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_H
@@ -1,14 +1,27 @@
 #include "dft.h"
+#include "../profile/trace.h"
+#include <cstring>
 
-static size_t buffer_size;
+// Row and column tiles per in-place pass; the scratch is about 1/inPlaceTiles of the matrix
+static const int inPlaceTiles = 8;
 
-struct Params {
-    int rows;
-    int cols;
+// Placement of one tile of an in-place pass, read by the kernels as the `tile` uniform. Zero rows or
+// cols means the pass is not tiled in that direction.
+struct TileOffsets {
+    int32_t rowOffset;
+    int32_t colOffset;
+    int32_t rows;
+    int32_t cols;
 };
 
-// CREATING BIND GROUP LAYOUT
-static wgpu::BindGroupLayout createBindGroupLayout(wgpu::Device& device) {
+// WGSL appended to the storage prelude: untiled passes see an all-zero `tile` constant, tiled passes
+// read it from binding 2, so one pipeline per shape serves every tile
+static const char* tileStruct = "struct TileOffsets { rowOffset: i32, colOffset: i32, rows: i32, cols: i32 }\n";
+static const char* untiledPrelude = "const tile = TileOffsets(0, 0, 0, 0);\n";
+static const char* tiledPrelude = "@group(0) @binding(2) var<uniform> tile: TileOffsets;\n";
+
+// CREATING BIND GROUP LAYOUT, with the TileOffsets uniform at binding 2 for tiled passes
+static wgpu::BindGroupLayout createBindGroupLayout(wgpu::Device& device, bool tiled = false) {
     wgpu::BindGroupLayoutEntry inputBufferLayout = {};
     inputBufferLayout.binding = 0;
     inputBufferLayout.visibility = wgpu::ShaderStage::Compute;
@@ -18,62 +31,276 @@ static wgpu::BindGroupLayout createBindGroupLayout(wgpu::Device& device) {
     outputBufferLayout.binding = 1;
     outputBufferLayout.visibility = wgpu::ShaderStage::Compute;
     outputBufferLayout.buffer.type = wgpu::BufferBindingType::Storage;
-    
-    wgpu::BindGroupLayoutEntry uniformBufferLayout = {};
-    uniformBufferLayout.binding = 2;
-    uniformBufferLayout.visibility = wgpu::ShaderStage::Compute;
-    uniformBufferLayout.buffer.type = wgpu::BufferBindingType::Uniform;
 
-    wgpu::BindGroupLayoutEntry inverseFlagLayout = {};
-    inverseFlagLayout.binding = 3;
-    inverseFlagLayout.visibility = wgpu::ShaderStage::Compute;
-    inverseFlagLayout.buffer.type = wgpu::BufferBindingType::Uniform;
+    wgpu::BindGroupLayoutEntry tileLayout = {};
+    tileLayout.binding = 2;
+    tileLayout.visibility = wgpu::ShaderStage::Compute;
+    tileLayout.buffer.type = wgpu::BufferBindingType::Uniform;
+    tileLayout.buffer.minBindingSize = sizeof(TileOffsets);
 
-    wgpu::BindGroupLayoutEntry entries[] = {inputBufferLayout, outputBufferLayout, uniformBufferLayout, inverseFlagLayout};
+    wgpu::BindGroupLayoutEntry entries[] = {inputBufferLayout, outputBufferLayout, tileLayout};
 
     wgpu::BindGroupLayoutDescriptor layoutDesc = {};
-    layoutDesc.entryCount = 4;      
+    layoutDesc.entryCount = tiled ? 3 : 2;
     layoutDesc.entries = entries;
 
     return device.createBindGroupLayout(layoutDesc);
 }
 
-// CREATING BIND GROUP
-static wgpu::BindGroup createBindGroup(wgpu::Device& device, wgpu::BindGroupLayout bindGroupLayout, wgpu::Buffer inputBuffer, wgpu::Buffer outputBuffer, wgpu::Buffer uniformBuffer, wgpu::Buffer inverseFlagBuffer) {
+// CREATING BIND GROUP over `inputSize` bytes of the input at `inputOffset` and `outputSize` bytes of the output at `outputOffset`,
+// plus the TileOffsets at `tileOffset` in `tileBuffer` for tiled passes
+static wgpu::BindGroup createBindGroup(
+    wgpu::Device& device,
+    wgpu::BindGroupLayout bindGroupLayout,
+    wgpu::Buffer inputBuffer,
+    uint64_t inputOffset,
+    uint64_t inputSize,
+    wgpu::Buffer outputBuffer,
+    uint64_t outputOffset,
+    uint64_t outputSize,
+    wgpu::Buffer tileBuffer = nullptr,
+    uint64_t tileOffset = 0
+) {
     wgpu::BindGroupEntry inputEntry = {};
     inputEntry.binding = 0;
     inputEntry.buffer = inputBuffer;
-    inputEntry.offset = 0;
-    inputEntry.size = sizeof(float) * 2 * buffer_size;
+    inputEntry.offset = inputOffset;
+    inputEntry.size = inputSize;
 
     wgpu::BindGroupEntry outputEntry = {};
     outputEntry.binding = 1;
     outputEntry.buffer = outputBuffer;
-    outputEntry.offset = 0;
-    outputEntry.size = sizeof(float) * 2 * buffer_size;
-
-    wgpu::BindGroupEntry uniformEntry = {};
-    uniformEntry.binding = 2;
-    uniformEntry.buffer = uniformBuffer;
-    uniformEntry.offset = 0;
-    uniformEntry.size = sizeof(Params);
-
-    wgpu::BindGroupEntry inverseFlagEntry = {};
-    inverseFlagEntry.binding = 3;
-    inverseFlagEntry.buffer = inverseFlagBuffer;
-    inverseFlagEntry.offset = 0;
-    inverseFlagEntry.size = sizeof(uint32_t);  
-    
-    wgpu::BindGroupEntry entries[] = {inputEntry, outputEntry, uniformEntry, inverseFlagEntry};
+    outputEntry.offset = outputOffset;
+    outputEntry.size = outputSize;
+
+    wgpu::BindGroupEntry tileEntry = {};
+    tileEntry.binding = 2;
+    tileEntry.buffer = tileBuffer;
+    tileEntry.offset = tileOffset;
+    tileEntry.size = sizeof(TileOffsets);
+
+    wgpu::BindGroupEntry entries[] = {inputEntry, outputEntry, tileEntry};
 
     wgpu::BindGroupDescriptor bindGroupDesc = {};
     bindGroupDesc.layout = bindGroupLayout;
-    bindGroupDesc.entryCount = 4;
+    bindGroupDesc.entryCount = tileBuffer ? 3 : 2;
     bindGroupDesc.entries = entries;
 
     return device.createBindGroup(bindGroupDesc);
 }
 
+// CREATING BIND GROUP over `size` bytes of each buffer starting at `offset`
+static wgpu::BindGroup createBindGroup(
+    wgpu::Device& device,
+    wgpu::BindGroupLayout bindGroupLayout,
+    wgpu::Buffer inputBuffer,
+    wgpu::Buffer outputBuffer,
+    uint64_t offset,
+    uint64_t size
+) {
+    return createBindGroup(device, bindGroupLayout, inputBuffer, offset, size, outputBuffer, offset, size);
+}
+
+// Shape, direction and normalization of one transform, shared by its row and column passes
+struct DftPassSettings {
+    std::string prelude;      // untiled passes
+    std::string tiledPrelude; // tiled passes, which read the `tile` uniform
+    WorkgroupLimits limits;
+    int rows;
+    int cols;
+    size_t elementSize;
+    std::vector<PipelineConstant> constants; // everything except ROWS and SCALE
+    double rowScale;
+    double colScale;
+};
+
+static DftPassSettings makeDftPassSettings(WebGPUContext& context, int rows, int cols, uint32_t doInverse, const TransformOptions& options) {
+    DftPassSettings settings;
+    settings.prelude = std::string(storagePrelude(options.storage)) + tileStruct + untiledPrelude;
+    settings.tiledPrelude = std::string(storagePrelude(options.storage)) + tileStruct + tiledPrelude;
+    settings.limits = getWorkgroupShape(context.device, options.workgroupX, options.workgroupY);
+    settings.rows = rows;
+    settings.cols = cols;
+    settings.elementSize = complexElementSize(options.storage);
+
+    // Shape, direction and workgroup size are baked into the pipelines as override constants
+    settings.constants = {
+        {"WORKGROUP_SIZE_X", settings.limits.maxWorkgroupSizeX},
+        {"WORKGROUP_SIZE_Y", settings.limits.maxWorkgroupSizeY},
+        {"COLS", double(cols)},
+        {"INVERSE", doInverse ? 1.0 : 0.0},
+        {"COMPENSATED", options.dftPrecision == DftPrecision::Compensated ? 1.0 : 0.0},
+    };
+
+    // Normalization is applied by the column pass. With f16 storage the row pass takes a share
+    // proportional to log(cols) so the intermediate stays within half-precision range.
+    const double scale = normalizationScale(options.normalization, doInverse != 0, rows, cols);
+    settings.rowScale = 1.0;
+    if (options.storage == StorageFormat::Float16 && rows * cols > 1) {
+        settings.rowScale = std::pow(scale, std::log(double(cols)) / std::log(double(rows) * double(cols)));
+    }
+    settings.colScale = scale / settings.rowScale;
+    return settings;
+}
+
+// ROW DFT PASS over `blockRows` rows starting `offset` bytes into both buffers
+static void runRowDft(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const DftPassSettings& settings,
+    wgpu::Buffer& inputBuffer,
+    wgpu::Buffer& intermediateBuffer,
+    uint64_t offset,
+    int blockRows
+) {
+    const uint64_t bytes = uint64_t(blockRows) * uint64_t(settings.cols) * settings.elementSize;
+    wgpu::BindGroup bindGroup = createBindGroup(context.device, bindGroupLayout, inputBuffer, intermediateBuffer, offset, bytes);
+
+    std::vector<PipelineConstant> constants = settings.constants;
+    constants.push_back({"ROWS", double(blockRows)});
+    constants.push_back({"SCALE", settings.rowScale});
+    wgpu::ComputePipeline pipeline = getComputePipeline(context, "src/dft/dft_row.wgsl", bindGroupLayout, constants, settings.prelude);
+
+    uint32_t workgroupsX = std::ceil(double(settings.cols) / settings.limits.maxWorkgroupSizeX);
+    uint32_t workgroupsY = std::ceil(double(blockRows) / settings.limits.maxWorkgroupSizeY);
+    // Compulsory traffic is one read and one write per element; each output accumulates `cols`
+    // complex multiply-adds (8 flops each)
+    const double elements = double(blockRows) * double(settings.cols);
+    const PassInfo pass = {"dft row", 2.0 * elements * double(settings.elementSize), 8.0 * elements * double(settings.cols)};
+    wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(context, pass, pipeline, bindGroup, workgroupsX, workgroupsY);
+    submitCommandBuffer(context, commandBuffer);
+
+    // Pipelines stay cached in the context
+    commandBuffer.release();
+    bindGroup.release();
+}
+
+// COLUMN DFT PASS over the whole matrix, or over `batch` contiguous matrices with one workgroup layer each
+static void runColumnDft(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const DftPassSettings& settings,
+    wgpu::Buffer& intermediateBuffer,
+    wgpu::Buffer& outputBuffer,
+    int batch = 1
+) {
+    const uint64_t bytes = uint64_t(batch) * uint64_t(settings.rows) * uint64_t(settings.cols) * settings.elementSize;
+    wgpu::BindGroup bindGroup = createBindGroup(context.device, bindGroupLayout, intermediateBuffer, outputBuffer, 0, bytes);
+
+    std::vector<PipelineConstant> constants = settings.constants;
+    constants.push_back({"ROWS", double(settings.rows)});
+    constants.push_back({"SCALE", settings.colScale});
+    wgpu::ComputePipeline pipeline = getComputePipeline(context, "src/dft/dft_col.wgsl", bindGroupLayout, constants, settings.prelude);
+
+    // Note: same workgroups for row pass & col pass
+    uint32_t workgroupsX = std::ceil(double(settings.cols) / settings.limits.maxWorkgroupSizeX);
+    uint32_t workgroupsY = std::ceil(double(settings.rows) / settings.limits.maxWorkgroupSizeY);
+    const double elements = double(batch) * double(settings.rows) * double(settings.cols);
+    const PassInfo pass = {"dft col", 2.0 * elements * double(settings.elementSize), 8.0 * elements * double(settings.rows)};
+    wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(context, pass, pipeline, bindGroup, workgroupsX, workgroupsY, uint32_t(batch));
+    submitCommandBuffer(context, commandBuffer);
+
+    commandBuffer.release();
+    bindGroup.release();
+}
+
+// ROW DFT PASS over the rows of one tile of the whole matrix, written to a tile.rows x cols scratch
+// tile. The rows are picked by the tile uniform at `tileOffset` rather than a binding offset, so a
+// tile may start on any row.
+static void runRowDftTile(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const DftPassSettings& settings,
+    wgpu::Buffer& dataBuffer,
+    wgpu::Buffer& scratchBuffer,
+    wgpu::Buffer& tileBuffer,
+    uint64_t tileOffset,
+    const TileOffsets& tile
+) {
+    const uint64_t bytes = uint64_t(settings.rows) * uint64_t(settings.cols) * settings.elementSize;
+    const uint64_t tileBytes = uint64_t(tile.rows) * uint64_t(settings.cols) * settings.elementSize;
+    wgpu::BindGroup bindGroup = createBindGroup(context.device, bindGroupLayout, dataBuffer, 0, bytes, scratchBuffer, 0, tileBytes, tileBuffer, tileOffset);
+
+    std::vector<PipelineConstant> constants = settings.constants;
+    constants.push_back({"ROWS", double(settings.rows)});
+    constants.push_back({"SCALE", settings.rowScale});
+    wgpu::ComputePipeline pipeline = getComputePipeline(context, "src/dft/dft_row.wgsl", bindGroupLayout, constants, settings.tiledPrelude);
+
+    uint32_t workgroupsX = std::ceil(double(settings.cols) / settings.limits.maxWorkgroupSizeX);
+    uint32_t workgroupsY = std::ceil(double(tile.rows) / settings.limits.maxWorkgroupSizeY);
+    const double elements = double(tile.rows) * double(settings.cols);
+    const PassInfo pass = {"dft row tile", 2.0 * elements * double(settings.elementSize), 8.0 * elements * double(settings.cols)};
+    wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(context, pass, pipeline, bindGroup, workgroupsX, workgroupsY);
+    submitCommandBuffer(context, commandBuffer);
+
+    commandBuffer.release();
+    bindGroup.release();
+}
+
+// COLUMN DFT PASS over the columns of one tile of the whole matrix, written to a rows x tile.cols
+// scratch tile
+static void runColumnDftTile(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const DftPassSettings& settings,
+    wgpu::Buffer& dataBuffer,
+    wgpu::Buffer& scratchBuffer,
+    wgpu::Buffer& tileBuffer,
+    uint64_t tileOffset,
+    const TileOffsets& tile
+) {
+    const uint64_t bytes = uint64_t(settings.rows) * uint64_t(settings.cols) * settings.elementSize;
+    const uint64_t tileBytes = uint64_t(settings.rows) * uint64_t(tile.cols) * settings.elementSize;
+    wgpu::BindGroup bindGroup = createBindGroup(context.device, bindGroupLayout, dataBuffer, 0, bytes, scratchBuffer, 0, tileBytes, tileBuffer, tileOffset);
+
+    std::vector<PipelineConstant> constants = settings.constants;
+    constants.push_back({"ROWS", double(settings.rows)});
+    constants.push_back({"SCALE", settings.colScale});
+    wgpu::ComputePipeline pipeline = getComputePipeline(context, "src/dft/dft_col.wgsl", bindGroupLayout, constants, settings.tiledPrelude);
+
+    uint32_t workgroupsX = std::ceil(double(tile.cols) / settings.limits.maxWorkgroupSizeX);
+    uint32_t workgroupsY = std::ceil(double(settings.rows) / settings.limits.maxWorkgroupSizeY);
+    const double elements = double(settings.rows) * double(tile.cols);
+    const PassInfo pass = {"dft col tile", 2.0 * elements * double(settings.elementSize), 8.0 * elements * double(settings.rows)};
+    wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(context, pass, pipeline, bindGroup, workgroupsX, workgroupsY);
+    submitCommandBuffer(context, commandBuffer);
+
+    commandBuffer.release();
+    bindGroup.release();
+}
+
+// TILE WRITEBACK of a tile.rows x tile.cols scratch tile to its place in the matrix
+static void runTileWriteback(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const DftPassSettings& settings,
+    wgpu::Buffer& scratchBuffer,
+    wgpu::Buffer& dataBuffer,
+    wgpu::Buffer& tileBuffer,
+    uint64_t tileOffset,
+    const TileOffsets& tile
+) {
+    const uint64_t bytes = uint64_t(settings.rows) * uint64_t(settings.cols) * settings.elementSize;
+    const uint64_t tileBytes = uint64_t(tile.rows) * uint64_t(tile.cols) * settings.elementSize;
+    wgpu::BindGroup bindGroup = createBindGroup(context.device, bindGroupLayout, scratchBuffer, 0, tileBytes, dataBuffer, 0, bytes, tileBuffer, tileOffset);
+
+    const std::vector<PipelineConstant> constants = {
+        {"WORKGROUP_SIZE_X", settings.limits.maxWorkgroupSizeX},
+        {"WORKGROUP_SIZE_Y", settings.limits.maxWorkgroupSizeY},
+        {"COLS", double(settings.cols)},
+    };
+    wgpu::ComputePipeline pipeline = getComputePipeline(context, "src/dft/dft_tile_writeback.wgsl", bindGroupLayout, constants, settings.tiledPrelude);
+
+    uint32_t workgroupsX = std::ceil(double(tile.cols) / settings.limits.maxWorkgroupSizeX);
+    uint32_t workgroupsY = std::ceil(double(tile.rows) / settings.limits.maxWorkgroupSizeY);
+    const PassInfo pass = {"dft tile writeback", 2.0 * double(tileBytes), 0.0};
+    wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(context, pass, pipeline, bindGroup, workgroupsX, workgroupsY);
+    submitCommandBuffer(context, commandBuffer);
+
+    commandBuffer.release();
+    bindGroup.release();
+}
+
 void dft(
     WebGPUContext& context, 
     wgpu::Buffer& finalOutputBuffer,
@@ -81,64 +308,157 @@ void dft(
     size_t buffersize,
     int rows, 
     int cols, 
-    uint32_t doInverse
+    uint32_t doInverse,
+    const TransformOptions& options
 ) {
-    buffer_size = buffersize;
-    Params params = {rows, cols};
+    TRACE_SCOPE("dft");
+    const size_t buffer_bytes = complexElementSize(options.storage) * buffersize;
+    const DftPassSettings settings = makeDftPassSettings(context, rows, cols, doInverse, options);
 
-    // Retrieve device and queue.
-    wgpu::Device device = context.device;
-    wgpu::Queue queue = context.queue;
-    WorkgroupLimits limits = getWorkgroupLimits(device);
-    limits.maxWorkgroupSizeX = std::min(limits.maxWorkgroupSizeX, sqrt(limits.maxInvocationsPerWorkgroup));
-    limits.maxWorkgroupSizeY = std::min(limits.maxWorkgroupSizeY, sqrt(limits.maxInvocationsPerWorkgroup));
+    // ROW DFT PASS -> save output in intermediate buffer before column pass
+    wgpu::Buffer intermediateBuffer = createBuffer(context, nullptr, buffer_bytes, WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
+    wgpu::BindGroupLayout bindGroupLayout = createBindGroupLayout(context.device);
+    runRowDft(context, bindGroupLayout, settings, inputBuffer, intermediateBuffer, 0, rows);
 
-    // Create the uniform buffer for dimensions.
-    wgpu::Buffer uniformBuffer = createBuffer(device, &params, sizeof(Params), wgpu::BufferUsage::Uniform);
+    // COLUMN DFT PASS
+    runColumnDft(context, bindGroupLayout, settings, intermediateBuffer, finalOutputBuffer);
 
-    uint32_t inverseFlag = doInverse ? 1 : 0;
-    wgpu::Buffer inverseFlagBuffer = createBuffer(device, &inverseFlag, sizeof(uint32_t), wgpu::BufferUsage::Uniform);  
+    // Clean all resources
+    bindGroupLayout.release();
+    releaseBuffer(context, intermediateBuffer);
+}
 
-    // ROW DFT PASS -> save output in intermediate buffer before column pass
-    wgpu::Buffer intermediateBuffer = createBuffer(device, nullptr, sizeof(float) * 2 * buffer_size, WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
+void dftInPlace(
+    WebGPUContext& context,
+    wgpu::Buffer& buffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("dft in place");
+    // Every output of a dense 1D DFT depends on every input, so a vector can only be transformed in
+    // place through a scratch as large as itself
+    if (rows < 2 || cols < 2) {
+        throw std::runtime_error("in-place DFT needs at least 2 rows and 2 columns; transform vectors with fft()");
+    }
+    const DftPassSettings settings = makeDftPassSettings(context, rows, cols, doInverse, options);
 
-    std::string shaderCodeRow = readShaderFile("src/dft/dft_row.wgsl", limits.maxWorkgroupSizeX, limits.maxWorkgroupSizeY);
-    wgpu::ShaderModule shaderModuleRow = createShaderModule(device, shaderCodeRow);
+    // The scratch holds one row tile or one column tile, each about 1/inPlaceTiles of the matrix
+    // and always smaller than it
+    const int tileRows = (rows + inPlaceTiles - 1) / inPlaceTiles;
+    const int tileCols = (cols + inPlaceTiles - 1) / inPlaceTiles;
+    const uint64_t scratchBytes = std::max(uint64_t(tileRows) * uint64_t(cols), uint64_t(rows) * uint64_t(tileCols)) * settings.elementSize;
+    wgpu::Buffer scratchBuffer = createBuffer(context, nullptr, scratchBytes, WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
+    wgpu::BindGroupLayout bindGroupLayout = createBindGroupLayout(context.device, true);
 
-    wgpu::BindGroupLayout bindGroupLayout = createBindGroupLayout(device);
-    wgpu::BindGroup bindGroupRow = createBindGroup(device, bindGroupLayout, inputBuffer, intermediateBuffer, uniformBuffer, inverseFlagBuffer);
-    wgpu::ComputePipeline computePipelineRow = createComputePipeline(device, shaderModuleRow, bindGroupLayout);
+    // Every tile's offsets go up in one uniform buffer, one aligned slot per tile: row tiles first,
+    // then column tiles
+    std::vector<TileOffsets> tiles;
+    for (int firstRow = 0; firstRow < rows; firstRow += tileRows) {
+        tiles.push_back({firstRow, 0, std::min(tileRows, rows - firstRow), cols});
+    }
+    const size_t rowTiles = tiles.size();
+    for (int firstCol = 0; firstCol < cols; firstCol += tileCols) {
+        tiles.push_back({0, firstCol, rows, std::min(tileCols, cols - firstCol)});
+    }
+    const uint64_t slotBytes = std::max<uint64_t>(sizeof(TileOffsets), getUniformBufferOffsetAlignment(context.device));
+    std::vector<unsigned char> slots(tiles.size() * slotBytes);
+    for (size_t index = 0; index < tiles.size(); ++index) {
+        std::memcpy(slots.data() + index * slotBytes, &tiles[index], sizeof(TileOffsets));
+    }
+    wgpu::Buffer tileBuffer = createBuffer(context, slots.data(), slots.size(), WGPUBufferUsage(wgpu::BufferUsage::Uniform));
 
-    // Note: same workgroups for row pass & col pass
-    uint32_t workgroupsX = std::ceil(double(cols)/limits.maxWorkgroupSizeX);
-    uint32_t workgroupsY = std::ceil(double(rows)/limits.maxWorkgroupSizeY);
+    // A row tile only reads its own rows and a column tile only the columns it writes back, so each
+    // tile is written back before the next is read
+    for (size_t index = 0; index < tiles.size(); ++index) {
+        const TileOffsets& tile = tiles[index];
+        if (index < rowTiles) {
+            runRowDftTile(context, bindGroupLayout, settings, buffer, scratchBuffer, tileBuffer, index * slotBytes, tile);
+        } else {
+            runColumnDftTile(context, bindGroupLayout, settings, buffer, scratchBuffer, tileBuffer, index * slotBytes, tile);
+        }
+        runTileWriteback(context, bindGroupLayout, settings, scratchBuffer, buffer, tileBuffer, index * slotBytes, tile);
+    }
 
-    wgpu::CommandBuffer commandBufferRow = createComputeCommandBuffer(device, computePipelineRow, bindGroupRow, workgroupsX, workgroupsY);
-    queue.submit(1, &commandBufferRow);
+    bindGroupLayout.release();
+    releaseBuffer(context, tileBuffer);
+    releaseBuffer(context, scratchBuffer);
+}
 
-    // Clean row pass resources before doing column pass
-    commandBufferRow.release();
-    computePipelineRow.release();
-    bindGroupRow.release();
-    shaderModuleRow.release();
+void dftBatched(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("dft batched");
+    const DftPassSettings settings = makeDftPassSettings(context, rows, cols, doInverse, options);
+    const size_t bytes = size_t(batch) * size_t(rows) * size_t(cols) * settings.elementSize;
 
-    // COLUMN DFT PASS
-    std::string shaderCodeCol = readShaderFile("src/dft/dft_col.wgsl", limits.maxWorkgroupSizeX, limits.maxWorkgroupSizeY);
-    wgpu::ShaderModule shaderModuleCol = createShaderModule(device, shaderCodeCol);
+    // Rows of different matrices are independent, so the row pass treats the batch as one tall matrix
+    wgpu::Buffer intermediateBuffer = createBuffer(context, nullptr, bytes, WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
+    wgpu::BindGroupLayout bindGroupLayout = createBindGroupLayout(context.device);
+    runRowDft(context, bindGroupLayout, settings, inputBuffer, intermediateBuffer, 0, batch * rows);
+    runColumnDft(context, bindGroupLayout, settings, intermediateBuffer, outputBuffer, batch);
+
+    bindGroupLayout.release();
+    releaseBuffer(context, intermediateBuffer);
+}
 
-    wgpu::BindGroup bindGroupCol = createBindGroup(device, bindGroupLayout, intermediateBuffer, finalOutputBuffer, uniformBuffer, inverseFlagBuffer);
-    wgpu::ComputePipeline computePipelineCol = createComputePipeline(device, shaderModuleCol, bindGroupLayout);
+void dftRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("dft rows");
+    // A 1 x cols transform has the 1D normalization, all of it applied by the row pass
+    DftPassSettings settings = makeDftPassSettings(context, 1, cols, doInverse, options);
+    settings.rows = rows;
+    settings.rowScale *= settings.colScale;
+    settings.colScale = 1.0;
 
-    wgpu::CommandBuffer commandBufferCol = createComputeCommandBuffer(device, computePipelineCol, bindGroupCol, workgroupsX, workgroupsY);
-    queue.submit(1, &commandBufferCol);
+    wgpu::BindGroupLayout bindGroupLayout = createBindGroupLayout(context.device);
+    runRowDft(context, bindGroupLayout, settings, inputBuffer, outputBuffer, 0, rows);
+    bindGroupLayout.release();
+}
+
+void dftStreamedRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    const RowBlockSource& source,
+    int blockRows
+) {
+    const DftPassSettings settings = makeDftPassSettings(context, rows, cols, doInverse, options);
+    const uint64_t rowBytes = uint64_t(cols) * settings.elementSize;
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    wgpu::Buffer inputBuffer = createBuffer(context, nullptr, rowBytes * rows, usage);
+    wgpu::Buffer intermediateBuffer = createBuffer(context, nullptr, rowBytes * rows, usage);
+    wgpu::BindGroupLayout bindGroupLayout = createBindGroupLayout(context.device);
+
+    // Each block's row pass is queued as soon as its upload is, so later uploads overlap it
+    blockRows = alignBlockRows(blockRows, rows, rowBytes, getStorageBufferOffsetAlignment(context.device));
+    for (int firstRow = 0; firstRow < rows; firstRow += blockRows) {
+        const int count = std::min(blockRows, rows - firstRow);
+        const uint64_t offset = uint64_t(firstRow) * rowBytes;
+        writeBuffer(context, inputBuffer, offset, source(firstRow, count), size_t(count * rowBytes));
+        runRowDft(context, bindGroupLayout, settings, inputBuffer, intermediateBuffer, offset, count);
+    }
+    runColumnDft(context, bindGroupLayout, settings, intermediateBuffer, outputBuffer);
 
-    // Clean all resources
-    commandBufferCol.release();
-    computePipelineCol.release();
-    bindGroupCol.release();
     bindGroupLayout.release();
-    shaderModuleCol.release();
-    uniformBuffer.release();
-    intermediateBuffer.release();
-    inverseFlagBuffer.release();
+    releaseBuffer(context, intermediateBuffer);
+    releaseBuffer(context, inputBuffer);
 }
@@ -7,6 +7,7 @@
 #include <vector>
 #include <webgpu/webgpu.hpp>
 #include "../webgpu_utils.h"
+#include "../transform_options.h"
 
 // Performs 2D Discrete Fourier Transform (naive O(N^2) algorithm)
 void dft(
@@ -16,7 +17,57 @@ void dft(
     size_t buffersize,
     int rows,
     int cols,
-    uint32_t doInverse
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Transforms `buffer` in place. Each pass runs in row or column tiles through a scratch of about
+// 1/8 of the matrix, written back before the next tile is read, instead of a full-size intermediate
+// buffer. Throws std::runtime_error for vectors (fewer than 2 rows or columns), which a dense DFT
+// cannot transform with less scratch than the vector itself.
+void dftInPlace(
+    WebGPUContext& context,
+    wgpu::Buffer& buffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Transforms `batch` contiguous rows x cols matrices with one row and one column dispatch
+void dftBatched(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Row pass only: a batch of `rows` 1D DFTs of length cols, normalized as 1D transforms
+void dftRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Uploads the input in row blocks, running the row pass on each block as it lands and the
+// column pass once all of them are in
+void dftStreamedRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    const RowBlockSource& source,
+    int blockRows
 );
 
 #endif 
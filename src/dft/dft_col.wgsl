@@ -1,42 +1,75 @@
-@group(0) @binding(0) var<storage, read> input: array<vec2<f32>>;
-@group(0) @binding(1) var<storage, read_write> output: array<vec2<f32>>;
-@group(0) @binding(2) var<uniform> dims: vec2<i32>; // rows, cols
-@group(0) @binding(3) var<uniform> doInverse: u32; // IDFT flag
+// storage_t (vec2<f32> or vec2<f16>) and `tile` are defined by the prelude the host prepends; `tile`
+// is a uniform in tiled passes and all zeros otherwise
+@group(0) @binding(0) var<storage, read> input: array<storage_t>;
+@group(0) @binding(1) var<storage, read_write> output: array<storage_t>;
 
-@compute @workgroup_size({{WORKGROUP_SIZE}})
+// Specialized per pipeline through ProgrammableStageDescriptor.constants
+override WORKGROUP_SIZE_X: u32 = 16u;
+override WORKGROUP_SIZE_Y: u32 = 16u;
+override ROWS: i32;
+override COLS: i32;
+override INVERSE: bool = false; // IDFT flag
+override COMPENSATED: bool = false; // exact integer phase reduction + Kahan summation
+override SCALE: f32 = 1.0; // normalization for the whole 2D transform
+
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y)
 fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
-    let col = i32(global_id.x); 
+    // A tiled pass covers columns tile.colOffset onward and writes a tile.cols wide scratch tile
+    let tileCol = i32(global_id.x);
+    let col = tile.colOffset + tileCol;
     let l = i32(global_id.y);   // freq index
-    if (col >= dims.y || l >= dims.x) {
+    let base = i32(global_id.z) * ROWS * COLS; // matrix of a batch, one per workgroup layer
+    if (col >= COLS || l >= ROWS || (tile.cols > 0 && tileCol >= tile.cols)) {
         return;
     }
     
     var sum = vec2<f32>(0.0, 0.0);
+    var compensation = vec2<f32>(0.0, 0.0); // low-order bits lost by each addition (compensated mode)
+    var phaseIndex = 0; // (l * row) mod ROWS, tracked exactly in integers (compensated mode)
     let pi = radians(180.0);
     
     // Determine sign based on inverse flag
-    let sign = select(-2.0, 2.0, doInverse == 1);
+    let sign = select(-2.0, 2.0, INVERSE);
 
     // Compute DFT/IDFT
-    for (var row = 0; row < dims.x; row = row + 1) {
-        let phase = fract(f32(row * l) / f32(dims.x)); // shrink phase to preserve precision
+    for (var row = 0; row < ROWS; row = row + 1) {
+        var phase: f32;
+        if (COMPENSATED) {
+            // Center the reduced index so the angle stays within [-pi, pi)
+            let centered = select(phaseIndex, phaseIndex - ROWS, 2 * phaseIndex >= ROWS);
+            phase = f32(centered) / f32(ROWS);
+            phaseIndex = phaseIndex + l;
+            if (phaseIndex >= ROWS) {
+                phaseIndex = phaseIndex - ROWS;
+            }
+        } else {
+            phase = fract(f32(row * l) / f32(ROWS)); // shrink phase to preserve precision
+        }
         let angle = sign * pi * phase;
         let euler = vec2<f32>(cos(angle), sin(angle));
-        let idx = row * dims.y + col;
-        let val = input[idx];
+        let idx = base + row * COLS + col;
+        let val = vec2<f32>(input[idx]);
 
         // Euler Rule
-        sum = sum + vec2<f32>(
+        let term = vec2<f32>(
             val.x * euler.x - val.y * euler.y,
             val.x * euler.y + val.y * euler.x
         );
+
+        if (COMPENSATED) {
+            // Kahan summation
+            let corrected = term - compensation;
+            let total = sum + corrected;
+            compensation = (total - sum) - corrected;
+            sum = total;
+        } else {
+            sum = sum + term;
+        }
     }
     
-    // For IDFT, normalize by N (dims.x in this case)
-    if (doInverse == 1) {
-        sum = sum / f32(dims.x);
-    }
+    // Normalization is applied once, here, after both passes
+    sum = sum * SCALE;
     
-    let outIndex = l * dims.y + col;
-    output[outIndex] = sum;
+    let outIndex = select(base + l * COLS + col, l * tile.cols + tileCol, tile.cols > 0);
+    output[outIndex] = storage_t(sum);
 }
\ No newline at end of file
@@ -1,42 +1,72 @@
-@group(0) @binding(0) var<storage, read> input: array<vec2<f32>>;
-@group(0) @binding(1) var<storage, read_write> output: array<vec2<f32>>;
-@group(0) @binding(2) var<uniform> dims: vec2<i32>; // rows, cols
-@group(0) @binding(3) var<uniform> doInverse: u32; // IDFT flag
+// storage_t (vec2<f32> or vec2<f16>) and `tile` are defined by the prelude the host prepends; `tile`
+// is a uniform in tiled passes and all zeros otherwise
+@group(0) @binding(0) var<storage, read> input: array<storage_t>;
+@group(0) @binding(1) var<storage, read_write> output: array<storage_t>;
 
-@compute @workgroup_size({{WORKGROUP_SIZE}})
+// Specialized per pipeline through ProgrammableStageDescriptor.constants
+override WORKGROUP_SIZE_X: u32 = 16u;
+override WORKGROUP_SIZE_Y: u32 = 16u;
+override ROWS: i32;
+override COLS: i32;
+override INVERSE: bool = false; // IDFT flag
+override COMPENSATED: bool = false; // exact integer phase reduction + Kahan summation
+override SCALE: f32 = 1.0; // share of the normalization, only used with f16 storage
+
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y)
 fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
     let col = i32(global_id.x); 
     let row = i32(global_id.y); 
-    if (col >= dims.y || row >= dims.x) {
+    // A tiled pass reads rows tile.rowOffset onward and writes its tile.rows rows from 0 of a scratch tile
+    if (col >= COLS || row >= ROWS || (tile.rows > 0 && row >= tile.rows)) {
         return;
     }
     
     var sum = vec2<f32>(0.0, 0.0);
+    var compensation = vec2<f32>(0.0, 0.0); // low-order bits lost by each addition (compensated mode)
+    var phaseIndex = 0; // (col * x) mod COLS, tracked exactly in integers (compensated mode)
     let pi = radians(180.0);
     
     // Determine sign based on inverse flag
-    let sign = select(-2.0, 2.0, doInverse == 1);
+    let sign = select(-2.0, 2.0, INVERSE);
     
     // Compute DFT/IDFT
-    for (var x = 0; x < dims.y; x = x + 1) {
-        let phase = fract(f32(col * x) / f32(dims.y)); // shrink phase to preserve precision
+    for (var x = 0; x < COLS; x = x + 1) {
+        var phase: f32;
+        if (COMPENSATED) {
+            // Center the reduced index so the angle stays within [-pi, pi)
+            let centered = select(phaseIndex, phaseIndex - COLS, 2 * phaseIndex >= COLS);
+            phase = f32(centered) / f32(COLS);
+            phaseIndex = phaseIndex + col;
+            if (phaseIndex >= COLS) {
+                phaseIndex = phaseIndex - COLS;
+            }
+        } else {
+            phase = fract(f32(col * x) / f32(COLS)); // shrink phase to preserve precision
+        }
         let angle = sign * pi * phase;
         let euler = vec2<f32>(cos(angle), sin(angle));
-        let idx = row * dims.y + x;
-        let val = input[idx];
+        let idx = (tile.rowOffset + row) * COLS + x;
+        let val = vec2<f32>(input[idx]);
 
         // Euler rule
-        sum = sum + vec2<f32>(
+        let term = vec2<f32>(
             val.x * euler.x - val.y * euler.y,
             val.x * euler.y + val.y * euler.x
         );
+
+        if (COMPENSATED) {
+            // Kahan summation
+            let corrected = term - compensation;
+            let total = sum + corrected;
+            compensation = (total - sum) - corrected;
+            sum = total;
+        } else {
+            sum = sum + term;
+        }
     }
     
-    // For IDFT, we need to divide by N (dims.y in this case)
-    if (doInverse == 1) {
-        sum = sum / f32(dims.y);
-    }
-    
-    let outIndex = row * dims.y + col;
-    output[outIndex] = sum;
+    sum = sum * SCALE;
+
+    let outIndex = row * COLS + col;
+    output[outIndex] = storage_t(sum);
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+// storage_t (vec2<f32> or vec2<f16>) and the `tile` uniform are defined by the prelude the host prepends
+@group(0) @binding(0) var<storage, read> scratch: array<storage_t>;
+@group(0) @binding(1) var<storage, read_write> data: array<storage_t>;
+
+// Specialized per pipeline through ProgrammableStageDescriptor.constants
+override WORKGROUP_SIZE_X: u32 = 16u;
+override WORKGROUP_SIZE_Y: u32 = 16u;
+override COLS: i32; // matrix columns
+
+// Copies a tile.rows x tile.cols scratch tile back to rows tile.rowOffset onward and columns
+// tile.colOffset onward of the row-major matrix
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y)
+fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
+    let tileCol = i32(global_id.x);
+    let row = i32(global_id.y);
+    if (tileCol >= tile.cols || tile.colOffset + tileCol >= COLS || row >= tile.rows) {
+        return;
+    }
+    data[(tile.rowOffset + row) * COLS + tile.colOffset + tileCol] = scratch[row * tile.cols + tileCol];
+}
@@ -1,16 +1,10 @@
 #include "fft.h"
 #include "../dft/dft.h"
+#include "../profile/trace.h"
+#include "../tune/tuner.h"
 #include <iostream>
 #include <cmath>
 
-static size_t buffer_size;
-
-struct FFTParams {
-    int rows;
-    int cols;
-    int stage;  // Which butterfly stage we're on
-};
-
 // CREATING BIND GROUP LAYOUT for FFT
 static wgpu::BindGroupLayout createFFTBindGroupLayout(wgpu::Device& device) {
     wgpu::BindGroupLayoutEntry inputBufferLayout = {};
@@ -18,61 +12,58 @@ static wgpu::BindGroupLayout createFFTBindGroupLayout(wgpu::Device& device) {
     inputBufferLayout.visibility = wgpu::ShaderStage::Compute;
     inputBufferLayout.buffer.type = wgpu::BufferBindingType::Storage;  // FFT needs read-write
 
-    wgpu::BindGroupLayoutEntry uniformBufferLayout = {};
-    uniformBufferLayout.binding = 1;
-    uniformBufferLayout.visibility = wgpu::ShaderStage::Compute;
-    uniformBufferLayout.buffer.type = wgpu::BufferBindingType::Uniform;
-
-    wgpu::BindGroupLayoutEntry inverseFlagLayout = {};
-    inverseFlagLayout.binding = 2;
-    inverseFlagLayout.visibility = wgpu::ShaderStage::Compute;
-    inverseFlagLayout.buffer.type = wgpu::BufferBindingType::Uniform;
-
-    wgpu::BindGroupLayoutEntry entries[] = {inputBufferLayout, uniformBufferLayout, inverseFlagLayout};
+    wgpu::BindGroupLayoutEntry entries[] = {inputBufferLayout};
 
     wgpu::BindGroupLayoutDescriptor layoutDesc = {};
-    layoutDesc.entryCount = 3;      
+    layoutDesc.entryCount = 1;      
     layoutDesc.entries = entries;
 
     return device.createBindGroupLayout(layoutDesc);
 }
 
-// CREATING BIND GROUP for FFT
+// CREATING BIND GROUP for FFT over `size` bytes starting at `offset`
 static wgpu::BindGroup createFFTBindGroup(
     wgpu::Device& device, 
     wgpu::BindGroupLayout bindGroupLayout, 
-    wgpu::Buffer dataBuffer, 
-    wgpu::Buffer uniformBuffer, 
-    wgpu::Buffer inverseFlagBuffer
+    wgpu::Buffer dataBuffer,
+    uint64_t offset,
+    uint64_t size
 ) {
     wgpu::BindGroupEntry inputEntry = {};
     inputEntry.binding = 0;
     inputEntry.buffer = dataBuffer;
-    inputEntry.offset = 0;
-    inputEntry.size = sizeof(float) * 2 * buffer_size;
-
-    wgpu::BindGroupEntry uniformEntry = {};
-    uniformEntry.binding = 1;
-    uniformEntry.buffer = uniformBuffer;
-    uniformEntry.offset = 0;
-    uniformEntry.size = sizeof(FFTParams);
-
-    wgpu::BindGroupEntry inverseFlagEntry = {};
-    inverseFlagEntry.binding = 2;
-    inverseFlagEntry.buffer = inverseFlagBuffer;
-    inverseFlagEntry.offset = 0;
-    inverseFlagEntry.size = sizeof(uint32_t);
-    
-    wgpu::BindGroupEntry entries[] = {inputEntry, uniformEntry, inverseFlagEntry};
+    inputEntry.offset = offset;
+    inputEntry.size = size;
+
+    wgpu::BindGroupEntry entries[] = {inputEntry};
 
     wgpu::BindGroupDescriptor bindGroupDesc = {};
     bindGroupDesc.layout = bindGroupLayout;
-    bindGroupDesc.entryCount = 3;
+    bindGroupDesc.entryCount = 1;
     bindGroupDesc.entries = entries;
 
     return device.createBindGroup(bindGroupDesc);
 }
 
+// DISPATCH ONE FFT PASS over the whole matrix using a cached specialized pipeline
+static void dispatchFFTPass(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    wgpu::BindGroup& bindGroup,
+    const std::string& shaderFile,
+    const PassInfo& pass,
+    const std::vector<PipelineConstant>& constants,
+    const std::string& prelude,
+    uint32_t workgroupsX,
+    uint32_t workgroupsY,
+    uint32_t workgroupsZ = 1
+) {
+    wgpu::ComputePipeline pipeline = getComputePipeline(context, shaderFile, bindGroupLayout, constants, prelude);
+    wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(context, pass, pipeline, bindGroup, workgroupsX, workgroupsY, workgroupsZ);
+    submitCommandBuffer(context, commandBuffer);
+    commandBuffer.release();
+}
+
 void fft(
     WebGPUContext& context,
     wgpu::Buffer& outputBuffer,
@@ -83,12 +74,182 @@ void fft(
     uint32_t doInverse,
     bool forceDft
 ) {
-    if (forceDft || !isValidFFTDimensions(rows, cols)) {
-        dft(context, outputBuffer, inputBuffer, buffersize, rows, cols, doInverse);
+    TransformOptions options;
+    options.forceDft = forceDft;
+    fft(context, outputBuffer, inputBuffer, buffersize, rows, cols, doInverse, options);
+}
+
+// A tuned plan replaces the default engine rule and workgroup shape unless the caller fixed either
+static TransformOptions planTransform(WebGPUContext& context, int rows, int cols, const TransformOptions& options) {
+    TransformOptions planned = options;
+    const TunedPlan* tuned = options.useWisdom && !options.forceDft && options.workgroupX == 0 && options.workgroupY == 0
+        ? findWisdom(context, rows, cols, options) : nullptr;
+    if (tuned) {
+        planned.forceDft = tuned->useDft;
+        planned.workgroupX = tuned->workgroupX;
+        planned.workgroupY = tuned->workgroupY;
+    }
+    return planned;
+}
+
+void fft(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    size_t buffersize,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("fft");
+    if (options.storage == StorageFormat::Float16 && !context.supportsF16) {
+        throw std::runtime_error("f16 storage requires the shader-f16 feature, which this device does not support");
+    }
+
+    const TransformOptions planned = planTransform(context, rows, cols, options);
+    if (planned.forceDft || !isValidFFTDimensions(rows, cols)) {
+        dft(context, outputBuffer, inputBuffer, buffersize, rows, cols, doInverse, planned);
         return;
     }
 
-    fftPowerOfTwo(context, outputBuffer, inputBuffer, buffersize, rows, cols, doInverse);
+    fftPowerOfTwo(context, outputBuffer, inputBuffer, buffersize, rows, cols, doInverse, planned);
+}
+
+// Both engines only submit work, so the transform is already asynchronous; the fence reports its completion
+AsyncJob fftAsync(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    size_t buffersize,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    fft(context, outputBuffer, inputBuffer, buffersize, rows, cols, doInverse, options);
+    return submitFence(context);
+}
+
+// Shape, direction and normalization of one transform, shared by its row and column passes
+struct FFTPassSettings {
+    std::string prelude;
+    WorkgroupLimits limits;
+    int rows;
+    int cols;
+    size_t elementSize;
+    uint32_t doInverse;
+    int numStagesRow;
+    int numStagesCol;
+    double scale;
+    bool spreadScale;
+    double stageScale;
+};
+
+static FFTPassSettings makeFFTPassSettings(WebGPUContext& context, int rows, int cols, uint32_t doInverse, const TransformOptions& options) {
+    FFTPassSettings settings;
+    settings.prelude = storagePrelude(options.storage);
+    settings.limits = getWorkgroupShape(context.device, options.workgroupX, options.workgroupY);
+    settings.rows = rows;
+    settings.cols = cols;
+    settings.elementSize = complexElementSize(options.storage);
+    settings.doInverse = doInverse;
+
+    // Normalization is applied once, by whichever butterfly stage runs last. With f16 storage it is
+    // instead split evenly over all stages so intermediate values stay within half-precision range.
+    settings.numStagesRow = log2Int(cols);
+    settings.numStagesCol = log2Int(rows);
+    settings.scale = normalizationScale(options.normalization, doInverse != 0, rows, cols);
+    settings.spreadScale = options.storage == StorageFormat::Float16 && settings.numStagesRow + settings.numStagesCol > 0;
+    settings.stageScale = settings.spreadScale ? std::pow(settings.scale, 1.0 / (settings.numStagesRow + settings.numStagesCol)) : 1.0;
+    return settings;
+}
+
+// Shape, direction and workgroup size are baked into the pipelines as override constants
+static std::vector<PipelineConstant> passConstants(const FFTPassSettings& settings, int rows, std::vector<PipelineConstant> extra) {
+    std::vector<PipelineConstant> constants = {
+        {"WORKGROUP_SIZE_X", settings.limits.maxWorkgroupSizeX},
+        {"WORKGROUP_SIZE_Y", settings.limits.maxWorkgroupSizeY},
+        {"ROWS", double(rows)},
+        {"COLS", double(settings.cols)},
+    };
+    constants.insert(constants.end(), extra.begin(), extra.end());
+    return constants;
+}
+
+static std::vector<PipelineConstant> butterflyConstants(const FFTPassSettings& settings, int rows, int stage, bool lastStage) {
+    return passConstants(settings, rows, {
+        {"STAGE", double(stage)},
+        {"INVERSE", settings.doInverse ? 1.0 : 0.0},
+        {"SCALE", settings.spreadScale ? settings.stageScale : (lastStage ? settings.scale : 1.0)},
+    });
+}
+
+// ROW FFT over `blockRows` rows starting `offset` bytes into the buffer. Row transforms are
+// independent, so the pass only needs that block to be resident.
+static void runRowFFT(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const FFTPassSettings& settings,
+    wgpu::Buffer& dataBuffer,
+    uint64_t offset,
+    int blockRows
+) {
+    const uint64_t bytes = uint64_t(blockRows) * uint64_t(settings.cols) * settings.elementSize;
+    wgpu::BindGroup bindGroup = createFFTBindGroup(context.device, bindGroupLayout, dataBuffer, offset, bytes);
+
+    // Note: every pass covers its rows with one invocation per element
+    uint32_t workgroupsX = std::ceil(double(settings.cols) / settings.limits.maxWorkgroupSizeX);
+    uint32_t workgroupsY = std::ceil(double(blockRows) / settings.limits.maxWorkgroupSizeY);
+
+    // Every pass reads and writes each element once; a butterfly stage costs 5 flops per element
+    const double elements = double(blockRows) * double(settings.cols);
+    const double passBytes = 2.0 * elements * double(settings.elementSize);
+
+    // Bit-reversal pass for rows
+    dispatchFFTPass(context, bindGroupLayout, bindGroup, "src/fft/fft_bit_reversal.wgsl", {"fft row bit reversal", passBytes, 0.0},
+        passConstants(settings, blockRows, {{"LOG2_COLS", double(settings.numStagesRow)}}), settings.prelude, workgroupsX, workgroupsY);
+
+    // Butterfly passes for rows (log2(cols) stages)
+    for (int stage = 0; stage < settings.numStagesRow; stage++) {
+        const bool lastStage = settings.numStagesCol == 0 && stage == settings.numStagesRow - 1;
+        dispatchFFTPass(context, bindGroupLayout, bindGroup, "src/fft/fft_butterfly.wgsl", {"fft row butterfly " + std::to_string(stage), passBytes, 5.0 * elements},
+            butterflyConstants(settings, blockRows, stage, lastStage), settings.prelude, workgroupsX, workgroupsY);
+    }
+
+    bindGroup.release();
+}
+
+// COLUMN FFT over the whole matrix, or over `batch` contiguous matrices with one workgroup layer each
+static void runColumnFFT(
+    WebGPUContext& context,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const FFTPassSettings& settings,
+    wgpu::Buffer& dataBuffer,
+    int batch = 1
+) {
+    const uint64_t bytes = uint64_t(batch) * uint64_t(settings.rows) * uint64_t(settings.cols) * settings.elementSize;
+    wgpu::BindGroup bindGroup = createFFTBindGroup(context.device, bindGroupLayout, dataBuffer, 0, bytes);
+
+    uint32_t workgroupsX = std::ceil(double(settings.cols) / settings.limits.maxWorkgroupSizeX);
+    uint32_t workgroupsY = std::ceil(double(settings.rows) / settings.limits.maxWorkgroupSizeY);
+    const uint32_t workgroupsZ = uint32_t(batch);
+
+    const double elements = double(batch) * double(settings.rows) * double(settings.cols);
+    const double passBytes = 2.0 * elements * double(settings.elementSize);
+
+    // Bit-reversal pass for columns
+    dispatchFFTPass(context, bindGroupLayout, bindGroup, "src/fft/fft_bit_reversal_col.wgsl", {"fft col bit reversal", passBytes, 0.0},
+        passConstants(settings, settings.rows, {{"LOG2_ROWS", double(settings.numStagesCol)}}), settings.prelude, workgroupsX, workgroupsY, workgroupsZ);
+
+    // Butterfly passes for columns (log2(rows) stages)
+    for (int stage = 0; stage < settings.numStagesCol; stage++) {
+        const bool lastStage = stage == settings.numStagesCol - 1;
+        dispatchFFTPass(context, bindGroupLayout, bindGroup, "src/fft/fft_butterfly_col.wgsl", {"fft col butterfly " + std::to_string(stage), passBytes, 5.0 * elements},
+            butterflyConstants(settings, settings.rows, stage, lastStage), settings.prelude, workgroupsX, workgroupsY, workgroupsZ);
+    }
+
+    bindGroup.release();
 }
 
 void fftPowerOfTwo(
@@ -98,152 +259,168 @@ void fftPowerOfTwo(
     size_t buffersize,
     int rows,
     int cols,
-    uint32_t doInverse
+    uint32_t doInverse,
+    const TransformOptions& options
 ) {
-    buffer_size = buffersize;
-    
-    wgpu::Device device = context.device;
-    wgpu::Queue queue = context.queue;
-    WorkgroupLimits limits = getWorkgroupLimits(device);
-    limits.maxWorkgroupSizeX = std::min(limits.maxWorkgroupSizeX, sqrt(limits.maxInvocationsPerWorkgroup));
-    limits.maxWorkgroupSizeY = std::min(limits.maxWorkgroupSizeY, sqrt(limits.maxInvocationsPerWorkgroup));
-
-    // Create temporary buffer for in-place FFT computation (copy input to output first)
-    wgpu::Buffer workBuffer = createBuffer(device, nullptr, sizeof(float) * 2 * buffer_size, 
-        WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst));
-
-    // Copy input to work buffer
-    wgpu::CommandEncoder encoder = device.createCommandEncoder();
-    encoder.copyBufferToBuffer(inputBuffer, 0, workBuffer, 0, sizeof(float) * 2 * buffer_size);
+    const size_t buffer_bytes = complexElementSize(options.storage) * buffersize;
+
+    // The passes work in place, so they run on the output after copying the input there; no
+    // full-size work buffer is needed
+    wgpu::CommandEncoder encoder = context.device.createCommandEncoder();
+    encodeBufferCopy(context, encoder, "fft copy in", inputBuffer, outputBuffer, buffer_bytes);
     wgpu::CommandBuffer cmdBuffer = encoder.finish();
-    queue.submit(1, &cmdBuffer);
+    submitCommandBuffer(context, cmdBuffer);
     cmdBuffer.release();
+    encoder.release();
 
-    uint32_t inverseFlag = doInverse ? 1 : 0;
-    wgpu::Buffer inverseFlagBuffer = createBuffer(device, &inverseFlag, sizeof(uint32_t), wgpu::BufferUsage::Uniform);
+    const FFTPassSettings settings = makeFFTPassSettings(context, rows, cols, doInverse, options);
+    wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(context.device);
 
     // ==================== ROW FFT ====================
-    {
-        wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(device);
-        
-        // Bit-reversal pass for rows
-        std::string bitRevShaderCode = readShaderFile("src/fft/fft_bit_reversal.wgsl", limits.maxWorkgroupSizeX, limits.maxWorkgroupSizeY);
-        wgpu::ShaderModule bitRevShaderModule = createShaderModule(device, bitRevShaderCode);
-        
-        FFTParams params = {rows, cols, 0};
-        wgpu::Buffer paramsBuffer = createBuffer(device, &params, sizeof(FFTParams), wgpu::BufferUsage::Uniform);
-        
-        wgpu::BindGroup bindGroup = createFFTBindGroup(device, bindGroupLayout, workBuffer, paramsBuffer, inverseFlagBuffer);
-        wgpu::ComputePipeline pipeline = createComputePipeline(device, bitRevShaderModule, bindGroupLayout);
-        
-        uint32_t workgroupsX = std::ceil(double(cols) / limits.maxWorkgroupSizeX);
-        uint32_t workgroupsY = std::ceil(double(rows) / limits.maxWorkgroupSizeY);
-        
-        wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(device, pipeline, bindGroup, workgroupsX, workgroupsY);
-        queue.submit(1, &commandBuffer);
-        
-        commandBuffer.release();
-        pipeline.release();
-        bindGroup.release();
-        bitRevShaderModule.release();
-        paramsBuffer.release();
-        bindGroupLayout.release();
+    runRowFFT(context, bindGroupLayout, settings, outputBuffer, 0, rows);
+
+    // ==================== COLUMN FFT ====================
+    runColumnFFT(context, bindGroupLayout, settings, outputBuffer);
+
+    bindGroupLayout.release();
+}
+
+void fftInPlace(
+    WebGPUContext& context,
+    wgpu::Buffer& buffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("fft in place");
+    if (options.storage == StorageFormat::Float16 && !context.supportsF16) {
+        throw std::runtime_error("f16 storage requires the shader-f16 feature, which this device does not support");
     }
 
-    // Butterfly passes for rows (log2(cols) stages)
-    int numStagesRow = log2Int(cols);
-    for (int stage = 0; stage < numStagesRow; stage++) {
-        wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(device);
-        
-        std::string butterflyShaderCode = readShaderFile("src/fft/fft_butterfly.wgsl", limits.maxWorkgroupSizeX, limits.maxWorkgroupSizeY);
-        wgpu::ShaderModule butterflyShaderModule = createShaderModule(device, butterflyShaderCode);
-        
-        FFTParams params = {rows, cols, stage};
-        wgpu::Buffer paramsBuffer = createBuffer(device, &params, sizeof(FFTParams), wgpu::BufferUsage::Uniform);
-        
-        wgpu::BindGroup bindGroup = createFFTBindGroup(device, bindGroupLayout, workBuffer, paramsBuffer, inverseFlagBuffer);
-        wgpu::ComputePipeline pipeline = createComputePipeline(device, butterflyShaderModule, bindGroupLayout);
-        
-        uint32_t workgroupsX = std::ceil(double(cols) / limits.maxWorkgroupSizeX);
-        uint32_t workgroupsY = std::ceil(double(rows) / limits.maxWorkgroupSizeY);
-        
-        wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(device, pipeline, bindGroup, workgroupsX, workgroupsY);
-        queue.submit(1, &commandBuffer);
-        
-        commandBuffer.release();
-        pipeline.release();
-        bindGroup.release();
-        butterflyShaderModule.release();
-        paramsBuffer.release();
-        bindGroupLayout.release();
+    const TransformOptions planned = planTransform(context, rows, cols, options);
+    // dftInPlace rejects vectors, so tuned wisdom may not send one there; only an explicit forceDft does
+    const bool isVector = rows < 2 || cols < 2;
+    const bool useDft = isVector ? options.forceDft : planned.forceDft;
+    if (useDft || !isValidFFTDimensions(rows, cols)) {
+        dftInPlace(context, buffer, rows, cols, doInverse, planned);
+        return;
     }
 
-    // ==================== COLUMN FFT ====================
-    {
-        wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(device);
-        
-        // Bit-reversal pass for columns
-        std::string bitRevShaderCode = readShaderFile("src/fft/fft_bit_reversal_col.wgsl", limits.maxWorkgroupSizeX, limits.maxWorkgroupSizeY);
-        wgpu::ShaderModule bitRevShaderModule = createShaderModule(device, bitRevShaderCode);
-        
-        FFTParams params = {rows, cols, 0};
-        wgpu::Buffer paramsBuffer = createBuffer(device, &params, sizeof(FFTParams), wgpu::BufferUsage::Uniform);
-        
-        wgpu::BindGroup bindGroup = createFFTBindGroup(device, bindGroupLayout, workBuffer, paramsBuffer, inverseFlagBuffer);
-        wgpu::ComputePipeline pipeline = createComputePipeline(device, bitRevShaderModule, bindGroupLayout);
-        
-        uint32_t workgroupsX = std::ceil(double(cols) / limits.maxWorkgroupSizeX);
-        uint32_t workgroupsY = std::ceil(double(rows) / limits.maxWorkgroupSizeY);
-        
-        wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(device, pipeline, bindGroup, workgroupsX, workgroupsY);
-        queue.submit(1, &commandBuffer);
-        
-        commandBuffer.release();
-        pipeline.release();
-        bindGroup.release();
-        bitRevShaderModule.release();
-        paramsBuffer.release();
-        bindGroupLayout.release();
+    // Bit reversal and butterflies already work in place, so they run on the caller's buffer directly
+    const FFTPassSettings settings = makeFFTPassSettings(context, rows, cols, doInverse, planned);
+    wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(context.device);
+    runRowFFT(context, bindGroupLayout, settings, buffer, 0, rows);
+    runColumnFFT(context, bindGroupLayout, settings, buffer);
+    bindGroupLayout.release();
+}
+
+void fftBatched(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("fft batched");
+    if (options.storage == StorageFormat::Float16 && !context.supportsF16) {
+        throw std::runtime_error("f16 storage requires the shader-f16 feature, which this device does not support");
     }
 
-    // Butterfly passes for columns (log2(rows) stages)
-    int numStagesCol = log2Int(rows);
-    for (int stage = 0; stage < numStagesCol; stage++) {
-        wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(device);
-        
-        std::string butterflyShaderCode = readShaderFile("src/fft/fft_butterfly_col.wgsl", limits.maxWorkgroupSizeX, limits.maxWorkgroupSizeY);
-        wgpu::ShaderModule butterflyShaderModule = createShaderModule(device, butterflyShaderCode);
-        
-        FFTParams params = {rows, cols, stage};
-        wgpu::Buffer paramsBuffer = createBuffer(device, &params, sizeof(FFTParams), wgpu::BufferUsage::Uniform);
-        
-        wgpu::BindGroup bindGroup = createFFTBindGroup(device, bindGroupLayout, workBuffer, paramsBuffer, inverseFlagBuffer);
-        wgpu::ComputePipeline pipeline = createComputePipeline(device, butterflyShaderModule, bindGroupLayout);
-        
-        uint32_t workgroupsX = std::ceil(double(cols) / limits.maxWorkgroupSizeX);
-        uint32_t workgroupsY = std::ceil(double(rows) / limits.maxWorkgroupSizeY);
-        
-        wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(device, pipeline, bindGroup, workgroupsX, workgroupsY);
-        queue.submit(1, &commandBuffer);
-        
-        commandBuffer.release();
-        pipeline.release();
-        bindGroup.release();
-        butterflyShaderModule.release();
-        paramsBuffer.release();
-        bindGroupLayout.release();
+    if (options.forceDft || !isValidFFTDimensions(rows, cols)) {
+        dftBatched(context, outputBuffer, inputBuffer, batch, rows, cols, doInverse, options);
+        return;
+    }
+
+    // The passes work in place, so they run on the output after copying the input there
+    const FFTPassSettings settings = makeFFTPassSettings(context, rows, cols, doInverse, options);
+    const uint64_t bytes = uint64_t(batch) * uint64_t(rows) * uint64_t(cols) * settings.elementSize;
+    wgpu::CommandEncoder encoder = context.device.createCommandEncoder();
+    encodeBufferCopy(context, encoder, "fft batched copy in", inputBuffer, outputBuffer, bytes);
+    wgpu::CommandBuffer commandBuffer = encoder.finish();
+    submitCommandBuffer(context, commandBuffer);
+    commandBuffer.release();
+    encoder.release();
+
+    wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(context.device);
+    runRowFFT(context, bindGroupLayout, settings, outputBuffer, 0, batch * rows);
+    runColumnFFT(context, bindGroupLayout, settings, outputBuffer, batch);
+    bindGroupLayout.release();
+}
+
+void fftRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    TRACE_SCOPE("fft rows");
+    if (options.storage == StorageFormat::Float16 && !context.supportsF16) {
+        throw std::runtime_error("f16 storage requires the shader-f16 feature, which this device does not support");
+    }
+
+    if (options.forceDft || !isPowerOf2(cols)) {
+        dftRows(context, outputBuffer, inputBuffer, rows, cols, doInverse, options);
+        return;
     }
 
-    // Copy result to output buffer
-    {
-        wgpu::CommandEncoder encoder = device.createCommandEncoder();
-        encoder.copyBufferToBuffer(workBuffer, 0, outputBuffer, 0, sizeof(float) * 2 * buffer_size);
-        wgpu::CommandBuffer cmdBuffer = encoder.finish();
-        queue.submit(1, &cmdBuffer);
-        cmdBuffer.release();
+    // A 1 x cols transform has no column stages, so the last row stage applies the 1D normalization
+    FFTPassSettings settings = makeFFTPassSettings(context, 1, cols, doInverse, options);
+    settings.rows = rows;
+    const uint64_t bytes = uint64_t(rows) * uint64_t(cols) * settings.elementSize;
+
+    // The row passes work in place, so they run on the output after copying the input there
+    wgpu::CommandEncoder encoder = context.device.createCommandEncoder();
+    encodeBufferCopy(context, encoder, "fft rows copy in", inputBuffer, outputBuffer, bytes);
+    wgpu::CommandBuffer commandBuffer = encoder.finish();
+    submitCommandBuffer(context, commandBuffer);
+    commandBuffer.release();
+    encoder.release();
+
+    wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(context.device);
+    runRowFFT(context, bindGroupLayout, settings, outputBuffer, 0, rows);
+    bindGroupLayout.release();
+}
+
+void fftStreamedRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    const RowBlockSource& source,
+    int blockRows
+) {
+    if (options.storage == StorageFormat::Float16 && !context.supportsF16) {
+        throw std::runtime_error("f16 storage requires the shader-f16 feature, which this device does not support");
+    }
+
+    if (options.forceDft || !isValidFFTDimensions(rows, cols)) {
+        dftStreamedRows(context, outputBuffer, rows, cols, doInverse, options, source, blockRows);
+        return;
+    }
+
+    // Blocks land directly in the output buffer, which then serves as the in-place work buffer
+    const FFTPassSettings settings = makeFFTPassSettings(context, rows, cols, doInverse, options);
+    const uint64_t rowBytes = uint64_t(cols) * settings.elementSize;
+    wgpu::BindGroupLayout bindGroupLayout = createFFTBindGroupLayout(context.device);
+
+    // Each block's row passes are queued as soon as its upload is, so later uploads overlap them
+    blockRows = alignBlockRows(blockRows, rows, rowBytes, getStorageBufferOffsetAlignment(context.device));
+    for (int firstRow = 0; firstRow < rows; firstRow += blockRows) {
+        const int count = std::min(blockRows, rows - firstRow);
+        const uint64_t offset = uint64_t(firstRow) * rowBytes;
+        writeBuffer(context, outputBuffer, offset, source(firstRow, count), size_t(count * rowBytes));
+        runRowFFT(context, bindGroupLayout, settings, outputBuffer, offset, count);
     }
+    runColumnFFT(context, bindGroupLayout, settings, outputBuffer);
 
-    // Cleanup
-    workBuffer.release();
-    inverseFlagBuffer.release();
+    bindGroupLayout.release();
 }
@@ -3,6 +3,7 @@
 
 #include <webgpu/webgpu.hpp>
 #include "../webgpu_utils.h"
+#include "../transform_options.h"
 #include "fft_utils.h"
 
 // Barebones API entry point allowing forced DFT
@@ -17,6 +18,83 @@ void fft(
     bool forceDft = false
 );
 
+// API entry point with engine and normalization options
+void fft(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    size_t buffersize,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+);
+
+// Queues the transform without waiting; the returned job completes when the GPU has finished it
+AsyncJob fftAsync(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    size_t buffersize,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Uploads the input in row blocks (rounded up to the storage offset alignment), running the row
+// pass on each block as it lands and the column pass once every block is in. Disk and PCIe
+// transfer of later blocks overlaps GPU work on earlier ones. Dispatches like fft().
+void fftStreamedRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    const RowBlockSource& source,
+    int blockRows
+);
+
+// Transforms `buffer`, holding rows x cols elements in the storage format, in place. Unlike fft() it
+// needs no second full-size buffer: the FFT passes run on `buffer` directly, and the DFT passes go
+// through a scratch of about 1/8 of the matrix. Engine selection and wisdom follow fft().
+void fftInPlace(
+    WebGPUContext& context,
+    wgpu::Buffer& buffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Transforms `batch` contiguous rows x cols matrices with the dispatch chain of a single transform:
+// the row passes treat the batch as one batch * rows tall matrix, and the column passes give each
+// matrix its own workgroup layer. The buffers hold the whole batch.
+void fftBatched(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
+// Transforms each row of a rows x cols matrix independently, i.e. a batch of `rows` 1D transforms of
+// length cols, normalized as 1D transforms. Power-of-2 lengths use the FFT passes, others the DFT.
+// Distributed transforms run it on row slabs and on transposed column slabs.
+void fftRows(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options = {}
+);
+
 // Internal Cooley-Tukey implementation for power-of-2 dimensions.
 void fftPowerOfTwo(
     WebGPUContext& context,
@@ -25,7 +103,8 @@ void fftPowerOfTwo(
     size_t buffersize,
     int rows,
     int cols,
-    uint32_t doInverse
+    uint32_t doInverse,
+    const TransformOptions& options = {}
 );
 
 #endif // FFT_H
@@ -1,35 +1,30 @@
-@group(0) @binding(0) var<storage, read_write> data: array<vec2<f32>>;
-@group(0) @binding(1) var<uniform> params: vec3<i32>; // x=rows, y=cols, z=stage
-@group(0) @binding(2) var<uniform> doInverse: u32;
+// storage_t (vec2<f32> or vec2<f16>) is defined by the prelude the host prepends
+@group(0) @binding(0) var<storage, read_write> data: array<storage_t>;
+
+// Specialized per pipeline through ProgrammableStageDescriptor.constants
+override WORKGROUP_SIZE_X: u32 = 16u;
+override WORKGROUP_SIZE_Y: u32 = 16u;
+override ROWS: i32;
+override COLS: i32;
+override LOG2_COLS: u32; // number of butterfly stages along a row
 
 // Bit-reverse permutation for rows
-@compute @workgroup_size({{WORKGROUP_SIZE}})
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y)
 fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
     let col = i32(global_id.x);
     let row = i32(global_id.y);
-    let cols = params.y;
-    let rows = params.x;
 
-    if (col >= cols || row >= rows) {
+    if (col >= COLS || row >= ROWS || LOG2_COLS == 0u) {
         return;
     }
 
     // Get bit-reversed index for this column
-    let n = u32(cols);
-    var reversed = 0u;
-    var col_bit = u32(col);
-    var temp = n;
-    
-    while (temp > 1u) {
-        reversed = (reversed << 1u) | (col_bit & 1u);
-        col_bit = col_bit >> 1u;
-        temp = temp >> 1u;
-    }
+    let reversed = i32(reverseBits(u32(col)) >> (32u - LOG2_COLS));
 
     // Only swap if reversed > col to avoid double swaps
-    if (i32(reversed) > col) {
-        let idx1 = row * cols + col;
-        let idx2 = row * cols + i32(reversed);
+    if (reversed > col) {
+        let idx1 = row * COLS + col;
+        let idx2 = row * COLS + reversed;
         
         let temp_val = data[idx1];
         data[idx1] = data[idx2];
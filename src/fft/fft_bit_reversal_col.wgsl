@@ -1,35 +1,31 @@
-@group(0) @binding(0) var<storage, read_write> data: array<vec2<f32>>;
-@group(0) @binding(1) var<uniform> params: vec3<i32>; // x=rows, y=cols, z=stage
-@group(0) @binding(2) var<uniform> doInverse: u32;
+// storage_t (vec2<f32> or vec2<f16>) is defined by the prelude the host prepends
+@group(0) @binding(0) var<storage, read_write> data: array<storage_t>;
+
+// Specialized per pipeline through ProgrammableStageDescriptor.constants
+override WORKGROUP_SIZE_X: u32 = 16u;
+override WORKGROUP_SIZE_Y: u32 = 16u;
+override ROWS: i32;
+override COLS: i32;
+override LOG2_ROWS: u32; // number of butterfly stages along a column
 
 // Bit-reverse permutation for columns
-@compute @workgroup_size({{WORKGROUP_SIZE}})
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y)
 fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
     let col = i32(global_id.x);
     let row = i32(global_id.y);
-    let cols = params.y;
-    let rows = params.x;
 
-    if (col >= cols || row >= rows) {
+    if (col >= COLS || row >= ROWS || LOG2_ROWS == 0u) {
         return;
     }
 
     // Get bit-reversed index for this row
-    let n = u32(rows);
-    var reversed = 0u;
-    var row_bit = u32(row);
-    var temp = n;
-    
-    while (temp > 1u) {
-        reversed = (reversed << 1u) | (row_bit & 1u);
-        row_bit = row_bit >> 1u;
-        temp = temp >> 1u;
-    }
+    let reversed = i32(reverseBits(u32(row)) >> (32u - LOG2_ROWS));
 
     // Only swap if reversed > row to avoid double swaps
-    if (i32(reversed) > row) {
-        let idx1 = row * cols + col;
-        let idx2 = i32(reversed) * cols + col;
+    if (reversed > row) {
+        let base = i32(global_id.z) * ROWS * COLS; // matrix of a batch, one per workgroup layer
+        let idx1 = base + row * COLS + col;
+        let idx2 = base + reversed * COLS + col;
         
         let temp_val = data[idx1];
         data[idx1] = data[idx2];
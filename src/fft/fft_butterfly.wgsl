@@ -1,14 +1,22 @@
-@group(0) @binding(0) var<storage, read_write> data: array<vec2<f32>>;
-@group(0) @binding(1) var<uniform> params: vec3<i32>; // x=rows, y=cols, z=stage
-@group(0) @binding(2) var<uniform> doInverse: u32;
+// storage_t (vec2<f32> or vec2<f16>) is defined by the prelude the host prepends
+@group(0) @binding(0) var<storage, read_write> data: array<storage_t>;
 
-@compute @workgroup_size({{WORKGROUP_SIZE}})
+// Specialized per pipeline through ProgrammableStageDescriptor.constants
+override WORKGROUP_SIZE_X: u32 = 16u;
+override WORKGROUP_SIZE_Y: u32 = 16u;
+override ROWS: i32;
+override COLS: i32;
+override STAGE: u32; // which butterfly stage we're on
+override INVERSE: bool = false;
+override SCALE: f32 = 1.0; // normalization share: final stage only, or every stage with f16 storage
+
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y)
 fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
     let col = i32(global_id.x);
     let row = i32(global_id.y);
-    let cols = params.y;
-    let rows = params.x;
-    let stage = u32(params.z);
+    let cols = COLS;
+    let rows = ROWS;
+    let stage = STAGE;
     
     if (col >= cols || row >= rows) {
         return;
@@ -33,14 +41,14 @@ fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
     let k = f32(offset);
     
     // Compute twiddle factor: exp(-2πi * k / m) for forward, exp(2πi * k / m) for inverse
-    let sign = select(-1.0, 1.0, doInverse == 1u);
+    let sign = select(-1.0, 1.0, INVERSE);
     let angle = sign * 2.0 * pi * k / f32(m);
     let w_real = cos(angle);
     let w_imag = sin(angle);
     
     // Get data values
-    let a = data[row * cols + idx1];
-    let b = data[row * cols + idx2];
+    let a = vec2<f32>(data[row * cols + idx1]);
+    let b = vec2<f32>(data[row * cols + idx2]);
     
     // Compute b * w
     let b_w = vec2<f32>(
@@ -48,13 +56,7 @@ fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
         b.x * w_imag + b.y * w_real
     );
     
-    // Butterfly: t = a + b*w, b_new = a - b*w
-    data[row * cols + idx1] = a + b_w;
-    data[row * cols + idx2] = a - b_w;
-    
-    // For inverse FFT, divide by 2 at each stage per element
-    if (doInverse == 1u) {
-        data[row * cols + idx1] = data[row * cols + idx1] * 0.5;
-        data[row * cols + idx2] = data[row * cols + idx2] * 0.5;
-    }
+    // Butterfly: t = a + b*w, b_new = a - b*w, scaled by this stage's share of the normalization
+    data[row * cols + idx1] = storage_t((a + b_w) * SCALE);
+    data[row * cols + idx2] = storage_t((a - b_w) * SCALE);
 }
@@ -0,0 +1,80 @@
+#ifndef HALF_H
+#define HALF_H
+
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 conversions for uploading and reading back f16 storage buffers
+
+// Converts a float to half precision, rounding to nearest even
+inline uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    // Inf and NaN (keep NaN quiet)
+    if (exponent == 0xFFu) {
+        return uint16_t(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+
+    const int halfExponent = int(exponent) - 127 + 15;
+    if (halfExponent >= 0x1F) {
+        return uint16_t(sign | 0x7C00u); // overflow to infinity
+    }
+
+    if (halfExponent <= 0) {
+        // Subnormal half (or zero)
+        if (halfExponent < -10) {
+            return uint16_t(sign);
+        }
+        mantissa |= 0x800000u;
+        const uint32_t shift = uint32_t(14 - halfExponent);
+        uint32_t halfMantissa = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u))) {
+            ++halfMantissa;
+        }
+        return uint16_t(sign | halfMantissa);
+    }
+
+    uint32_t half = sign | (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        ++half; // may carry into the exponent, which correctly rounds up to infinity
+    }
+    return uint16_t(half);
+}
+
+// Converts a half-precision value to float (exact)
+inline float halfToFloat(uint16_t half) {
+    const uint32_t sign = uint32_t(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+
+    uint32_t bits;
+    if (exponent == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // Normalize the subnormal half
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#endif // HALF_H
@@ -0,0 +1,130 @@
+#include "matrix_file.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char matrixMagic[4] = {'W', 'D', 'F', 'T'};
+static const uint32_t matrixVersion = 1;
+
+// The header is stored little-endian; decode it byte by byte so big-endian hosts read it correctly
+static uint32_t readLittleEndian32(const unsigned char* bytes) {
+    return uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+}
+
+// MAPPING FILES
+bool mapFile(const std::string& path, MappedFile& file) {
+#ifndef _WIN32
+    file.fd = open(path.c_str(), O_RDONLY);
+    if (file.fd < 0) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    struct stat status = {};
+    if (fstat(file.fd, &status) != 0) {
+        std::cerr << "Failed to stat " << path << std::endl;
+        close(file.fd);
+        file.fd = -1;
+        return false;
+    }
+    file.size = size_t(status.st_size);
+    if (file.size == 0) {
+        file.data = nullptr;
+        return true;
+    }
+
+    void* mapping = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to mmap " << path << std::endl;
+        close(file.fd);
+        file.fd = -1;
+        return false;
+    }
+    // The upload reads the mapping front to back exactly once
+    madvise(mapping, file.size, MADV_SEQUENTIAL);
+    file.data = static_cast<const unsigned char*>(mapping);
+    return true;
+#else
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+    stream.seekg(0, std::ios::end);
+    file.fallback.resize(size_t(stream.tellg()));
+    stream.seekg(0, std::ios::beg);
+    stream.read(reinterpret_cast<char*>(file.fallback.data()), std::streamsize(file.fallback.size()));
+    file.data = file.fallback.data();
+    file.size = file.fallback.size();
+    return true;
+#endif
+}
+
+void unmapFile(MappedFile& file) {
+#ifndef _WIN32
+    if (file.fd >= 0) {
+        if (file.data) {
+            munmap(const_cast<unsigned char*>(file.data), file.size);
+        }
+        close(file.fd);
+    }
+#endif
+    file.fallback.clear();
+    file.data = nullptr;
+    file.size = 0;
+    file.fd = -1;
+}
+
+// PARSING THE RAW MATRIX FORMAT
+bool isMatrixFile(const MappedFile& file) {
+    return file.size >= sizeof(MatrixFileHeader) && std::memcmp(file.data, matrixMagic, sizeof(matrixMagic)) == 0;
+}
+
+size_t matrixDtypeSize(MatrixDtype dtype) {
+    return dtype == MatrixDtype::Complex32 ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+}
+
+bool parseMatrixFile(const MappedFile& file, MatrixView& view) {
+    if (!isMatrixFile(file)) {
+        std::cerr << "Not a raw matrix file (missing WDFT header)" << std::endl;
+        return false;
+    }
+
+    const unsigned char* header = file.data;
+    const uint32_t version = readLittleEndian32(header + 4);
+    const uint32_t rows = readLittleEndian32(header + 8);
+    const uint32_t cols = readLittleEndian32(header + 12);
+    const uint32_t dtype = readLittleEndian32(header + 16);
+    const uint32_t layout = readLittleEndian32(header + 20);
+
+    if (version != matrixVersion) {
+        std::cerr << "Unsupported matrix file version " << version << std::endl;
+        return false;
+    }
+    if (dtype != uint32_t(MatrixDtype::Complex64) && dtype != uint32_t(MatrixDtype::Complex32)) {
+        std::cerr << "Unsupported matrix dtype " << dtype << std::endl;
+        return false;
+    }
+    if (layout != uint32_t(MatrixLayout::RowMajorInterleaved)) {
+        std::cerr << "Unsupported matrix layout " << layout << std::endl;
+        return false;
+    }
+
+    view.rows = int(rows);
+    view.cols = int(cols);
+    view.dtype = MatrixDtype(dtype);
+    view.bytes = size_t(rows) * size_t(cols) * matrixDtypeSize(view.dtype);
+    if (file.size - sizeof(MatrixFileHeader) < view.bytes) {
+        std::cerr << "Matrix file is truncated: expected " << view.bytes << " data bytes" << std::endl;
+        return false;
+    }
+    view.data = file.data + sizeof(MatrixFileHeader);
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Raw matrix file: a 32-byte little-endian header followed by the matrix data
+//
+//   offset  size  field
+//   0       4     magic "WDFT"
+//   4       4     version (1)
+//   8       4     rows
+//   12      4     cols
+//   16      4     dtype  (MatrixDtype)
+//   20      4     layout (MatrixLayout)
+//   24      8     reserved, zero
+//
+// The data starts at offset 32 and is rows * cols complex elements.
+
+enum class MatrixDtype : uint32_t {
+    Complex64 = 1, // interleaved f32 real/imag pairs
+    Complex32 = 2, // interleaved f16 real/imag pairs
+};
+
+enum class MatrixLayout : uint32_t {
+    RowMajorInterleaved = 1,
+};
+
+struct MatrixFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t dtype;
+    uint32_t layout;
+    uint64_t reserved;
+};
+static_assert(sizeof(MatrixFileHeader) == 32, "matrix file header must be 32 bytes");
+
+// Read-only view of a whole file, memory-mapped where the platform allows it
+struct MappedFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    int fd = -1;
+    std::vector<unsigned char> fallback; // used when mmap is unavailable
+};
+
+// Matrix described by a mapped file; `data` points into the mapping
+struct MatrixView {
+    int rows = 0;
+    int cols = 0;
+    MatrixDtype dtype = MatrixDtype::Complex64;
+    const void* data = nullptr;
+    size_t bytes = 0;
+};
+
+// Maps a file read-only; returns false (after printing the reason) on failure
+bool mapFile(const std::string& path, MappedFile& file);
+
+// Unmaps a file mapped by mapFile
+void unmapFile(MappedFile& file);
+
+// Whether a mapped file starts with the raw matrix header magic
+bool isMatrixFile(const MappedFile& file);
+
+// Validates the header of a raw matrix file and points the view at its data
+bool parseMatrixFile(const MappedFile& file, MatrixView& view);
+
+// Bytes per element of a matrix dtype
+size_t matrixDtypeSize(MatrixDtype dtype);
+
+#endif // MATRIX_FILE_H
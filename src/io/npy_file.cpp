@@ -0,0 +1,130 @@
+#include "npy_file.h"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+static const char npyMagic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+
+// Returns the text following `'key':` in the header dict, or an empty string
+static std::string findDictValue(const std::string& dict, const std::string& key) {
+    const std::string quotedKey = "'" + key + "'";
+    size_t position = dict.find(quotedKey);
+    if (position == std::string::npos) {
+        return "";
+    }
+    position = dict.find(':', position + quotedKey.size());
+    if (position == std::string::npos) {
+        return "";
+    }
+    return dict.substr(position + 1);
+}
+
+// Whether a dict value (as returned by findDictValue) begins with the expected literal
+static bool valueStartsWith(const std::string& value, const std::string& expected) {
+    const size_t start = value.find_first_not_of(' ');
+    return start != std::string::npos && value.compare(start, expected.size(), expected) == 0;
+}
+
+bool isNpyFile(const MappedFile& file) {
+    return file.size >= 10 && std::memcmp(file.data, npyMagic, sizeof(npyMagic)) == 0;
+}
+
+// PARSING .npy FILES
+bool parseNpyFile(const MappedFile& file, MatrixView& view) {
+    if (!isNpyFile(file)) {
+        std::cerr << "Not a .npy file (missing magic string)" << std::endl;
+        return false;
+    }
+
+    // Version 1.0 stores a 2-byte header length, versions 2.0 and 3.0 a 4-byte one
+    const unsigned char major = file.data[6];
+    size_t headerLength = 0;
+    size_t dictOffset = 0;
+    if (major == 1) {
+        headerLength = size_t(file.data[8]) | (size_t(file.data[9]) << 8);
+        dictOffset = 10;
+    } else if ((major == 2 || major == 3) && file.size >= 12) {
+        headerLength = size_t(file.data[8]) | (size_t(file.data[9]) << 8) |
+            (size_t(file.data[10]) << 16) | (size_t(file.data[11]) << 24);
+        dictOffset = 12;
+    } else {
+        std::cerr << "Unsupported .npy version " << int(major) << std::endl;
+        return false;
+    }
+    if (dictOffset + headerLength > file.size) {
+        std::cerr << ".npy header is truncated" << std::endl;
+        return false;
+    }
+    const std::string dict(reinterpret_cast<const char*>(file.data + dictOffset), headerLength);
+
+    if (!valueStartsWith(findDictValue(dict, "descr"), "'<c8'")) {
+        std::cerr << ".npy input must be complex64 ('<c8')" << std::endl;
+        return false;
+    }
+    if (!valueStartsWith(findDictValue(dict, "fortran_order"), "False")) {
+        std::cerr << ".npy input must be C-ordered" << std::endl;
+        return false;
+    }
+
+    // Shape is a tuple such as (512, 512)
+    const std::string shapeText = findDictValue(dict, "shape");
+    const size_t open = shapeText.find('(');
+    const size_t close = shapeText.find(')');
+    if (open == std::string::npos || close == std::string::npos || close < open) {
+        std::cerr << ".npy header has no shape" << std::endl;
+        return false;
+    }
+    std::vector<size_t> shape;
+    std::stringstream tuple(shapeText.substr(open + 1, close - open - 1));
+    std::string dimension;
+    while (std::getline(tuple, dimension, ',')) {
+        if (dimension.find_first_of("0123456789") != std::string::npos) {
+            shape.push_back(std::stoull(dimension));
+        }
+    }
+    if (shape.size() != 2) {
+        std::cerr << ".npy input must be a 2D array" << std::endl;
+        return false;
+    }
+
+    view.rows = int(shape[0]);
+    view.cols = int(shape[1]);
+    view.dtype = MatrixDtype::Complex64;
+    view.bytes = shape[0] * shape[1] * matrixDtypeSize(view.dtype);
+    const size_t dataOffset = dictOffset + headerLength;
+    if (file.size - dataOffset < view.bytes) {
+        std::cerr << ".npy file is truncated: expected " << view.bytes << " data bytes" << std::endl;
+        return false;
+    }
+    view.data = file.data + dataOffset;
+    return true;
+}
+
+// WRITING .npy HEADERS
+std::string makeNpyHeader(const std::vector<size_t>& shape) {
+    std::string dict = "{'descr': '<c8', 'fortran_order': False, 'shape': (";
+    for (size_t index = 0; index < shape.size(); ++index) {
+        dict += std::to_string(shape[index]);
+        if (index + 1 < shape.size() || shape.size() == 1) {
+            dict += ",";
+        }
+        if (index + 1 < shape.size()) {
+            dict += " ";
+        }
+    }
+    dict += "), }";
+
+    // Pad with spaces so the data starts on a 64-byte boundary, terminated by a newline
+    const size_t prefixSize = sizeof(npyMagic) + 2 + 2;
+    const size_t unpadded = prefixSize + dict.size() + 1;
+    dict.append((64 - unpadded % 64) % 64, ' ');
+    dict += '\n';
+
+    std::string header(npyMagic, sizeof(npyMagic));
+    header += char(1); // version 1.0
+    header += char(0);
+    header += char(dict.size() & 0xFF);
+    header += char((dict.size() >> 8) & 0xFF);
+    header += dict;
+    return header;
+}
@@ -0,0 +1,20 @@
+#ifndef NPY_FILE_H
+#define NPY_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "matrix_file.h"
+
+// NumPy .npy support for C-ordered complex64 arrays ('<c8')
+
+// Whether a mapped file starts with the .npy magic string
+bool isNpyFile(const MappedFile& file);
+
+// Validates a 2D complex64 .npy file and points the view at its data
+bool parseNpyFile(const MappedFile& file, MatrixView& view);
+
+// Builds a complete .npy header (magic, version, length and dict) for a complex64 array
+std::string makeNpyHeader(const std::vector<size_t>& shape);
+
+#endif // NPY_FILE_H
@@ -0,0 +1,55 @@
+#include "output_file.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+int openOutputFile(const std::string& path) {
+#ifdef _WIN32
+    const int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << ": " << std::strerror(errno) << std::endl;
+    }
+    return fd;
+}
+
+bool writeToFile(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        // _write takes an unsigned int count
+        const unsigned int chunk = size > (1u << 30) ? (1u << 30) : unsigned(size);
+        const int written = _write(fd, bytes, chunk);
+#else
+        const ssize_t written = write(fd, bytes, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Failed to write output: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        bytes += written;
+        size -= size_t(written);
+    }
+    return true;
+}
+
+void closeOutputFile(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
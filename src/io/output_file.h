@@ -0,0 +1,18 @@
+#ifndef OUTPUT_FILE_H
+#define OUTPUT_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Unbuffered file output, so mapped GPU readback ranges reach the kernel without a host-side copy
+
+// Opens (creating or truncating) a file for writing; returns -1 after printing the reason on failure
+int openOutputFile(const std::string& path);
+
+// Writes the whole range, retrying short writes
+bool writeToFile(int fd, const void* data, size_t size);
+
+// Closes a file opened by openOutputFile
+void closeOutputFile(int fd);
+
+#endif // OUTPUT_FILE_H
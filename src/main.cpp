@@ -1,13 +1,30 @@
 #define WEBGPU_CPP_IMPLEMENTATION
+#include "batch/coalescer.h"
+#include "batch/hybrid.h"
+#include "cpu/cpu_fft.h"
 #include "fft/fft.h"
+#include "half.h"
+#include "io/matrix_file.h"
+#include "io/npy_file.h"
+#include "io/output_file.h"
+#include "multi/distributed.h"
+#include "multi/multi_gpu.h"
+#include "profile/bandwidth.h"
+#include "profile/counters.h"
+#include "profile/trace.h"
+#include "server/server.h"
+#include "stream/stream.h"
+#include "tune/tuner.h"
 #include "webgpu_utils.h"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <complex>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -21,17 +38,55 @@ enum class TransformMode {
 };
 
 struct ParsedArgs {
-    bool forceDft = false;
+    TransformOptions options;
     TransformMode mode = TransformMode::Both;
     int benchmarkRepeats = 0;
+    int tuneRepeats = 0; // runs per tuning candidate; 0 skips tuning
+    int streamFrames = 0;
+    int streamSlots = 3;
+    int hybridBatch = 0; // matrices per hybrid CPU+GPU batch; 0 disables
+    int coalesceRequests = 0; // concurrent requests sent through the batching scheduler; 0 disables
+    int coalesceWindowUs = 200; // how long the scheduler holds a request for others to join it
+    int multiGpuBatch = 0; // matrices per batch spread over every adapter; 0 disables
+    int slabs = -1; // slab count of a distributed transform; 0 picks one, -1 disables
+    bool allAdapters = false; // let --multi-gpu and --slabs use software adapters alongside hardware ones
+    bool profile = false;
+    bool counters = false; // print runtime counters before exiting
+    bool cpu = false;      // use the CPU engine even when a WebGPU device is available
+    int cpuThreads = 0;    // CPU engine threads; 0 uses one per hardware thread
+    int blockRows = 0; // row-block upload height; 0 uploads the whole matrix first
+    bool inPlace = false; // upload into each result buffer and transform it there, with no input buffer
+    string inputPath = "tests/artifacts/input.txt";
+    string outputPath; // .npy file; results are printed as text when empty
+    string tracePath;  // Chrome trace-event JSON; requires a WGPU_DFT_TRACING build
+    string wisdomPath; // tuned plans, loaded at startup and rewritten after --tune
+    string socketPath; // Unix domain socket to serve jobs on; empty runs the input once
+    int cacheMegabytes = 0; // device memory for the server's result cache; 0 disables it
 };
 
+Normalization parseNormalization(const string& name) {
+    if (name == "backward") {
+        return Normalization::Backward;
+    }
+    if (name == "ortho") {
+        return Normalization::Ortho;
+    }
+    if (name == "forward") {
+        return Normalization::Forward;
+    }
+    if (name == "none") {
+        return Normalization::None;
+    }
+    cerr << "Unknown normalization '" << name << "', using backward" << endl;
+    return Normalization::Backward;
+}
+
 ParsedArgs parseArgs(int argc, char* argv[]) {
     ParsedArgs args;
     for (int index = 1; index < argc; ++index) {
         const string arg(argv[index]);
         if (arg == "--force-dft" || arg == "dft") {
-            args.forceDft = true;
+            args.options.forceDft = true;
             continue;
         }
         if (arg == "--mode=forward" || arg == "forward") {
@@ -42,6 +97,131 @@ ParsedArgs parseArgs(int argc, char* argv[]) {
             args.mode = TransformMode::Backward;
             continue;
         }
+        const string normPrefix = "--norm=";
+        if (arg.rfind(normPrefix, 0) == 0) {
+            args.options.normalization = parseNormalization(arg.substr(normPrefix.size()));
+            continue;
+        }
+        if (arg == "--storage=f16") {
+            args.options.storage = StorageFormat::Float16;
+            continue;
+        }
+        if (arg == "--storage=f32") {
+            args.options.storage = StorageFormat::Float32;
+            continue;
+        }
+        if (arg == "--dft-precision=compensated") {
+            args.options.dftPrecision = DftPrecision::Compensated;
+            continue;
+        }
+        if (arg == "--dft-precision=standard") {
+            args.options.dftPrecision = DftPrecision::Standard;
+            continue;
+        }
+        const string inputPrefix = "--input=";
+        if (arg.rfind(inputPrefix, 0) == 0) {
+            args.inputPath = arg.substr(inputPrefix.size());
+            continue;
+        }
+        const string outputPrefix = "--output=";
+        if (arg.rfind(outputPrefix, 0) == 0) {
+            args.outputPath = arg.substr(outputPrefix.size());
+            continue;
+        }
+        const string streamPrefix = "--stream=";
+        if (arg.rfind(streamPrefix, 0) == 0) {
+            args.streamFrames = stoi(arg.substr(streamPrefix.size()));
+            continue;
+        }
+        const string hybridPrefix = "--hybrid=";
+        if (arg.rfind(hybridPrefix, 0) == 0) {
+            args.hybridBatch = stoi(arg.substr(hybridPrefix.size()));
+            continue;
+        }
+        const string multiGpuPrefix = "--multi-gpu=";
+        if (arg.rfind(multiGpuPrefix, 0) == 0) {
+            args.multiGpuBatch = stoi(arg.substr(multiGpuPrefix.size()));
+            continue;
+        }
+        const string servePrefix = "--serve=";
+        if (arg.rfind(servePrefix, 0) == 0) {
+            args.socketPath = arg.substr(servePrefix.size());
+            continue;
+        }
+        const string cachePrefix = "--cache-mb=";
+        if (arg.rfind(cachePrefix, 0) == 0) {
+            args.cacheMegabytes = stoi(arg.substr(cachePrefix.size()));
+            continue;
+        }
+        const string slabsPrefix = "--slabs=";
+        if (arg.rfind(slabsPrefix, 0) == 0) {
+            args.slabs = stoi(arg.substr(slabsPrefix.size()));
+            continue;
+        }
+        if (arg == "--all-adapters") {
+            args.allAdapters = true;
+            continue;
+        }
+        const string coalescePrefix = "--coalesce=";
+        if (arg.rfind(coalescePrefix, 0) == 0) {
+            args.coalesceRequests = stoi(arg.substr(coalescePrefix.size()));
+            continue;
+        }
+        const string windowPrefix = "--coalesce-window=";
+        if (arg.rfind(windowPrefix, 0) == 0) {
+            args.coalesceWindowUs = stoi(arg.substr(windowPrefix.size()));
+            continue;
+        }
+        const string slotsPrefix = "--stream-slots=";
+        if (arg.rfind(slotsPrefix, 0) == 0) {
+            args.streamSlots = stoi(arg.substr(slotsPrefix.size()));
+            continue;
+        }
+        if (arg == "--profile") {
+            args.profile = true;
+            continue;
+        }
+        if (arg == "--in-place") {
+            args.inPlace = true;
+            continue;
+        }
+        if (arg == "--cpu") {
+            args.cpu = true;
+            continue;
+        }
+        const string cpuThreadsPrefix = "--cpu-threads=";
+        if (arg.rfind(cpuThreadsPrefix, 0) == 0) {
+            args.cpuThreads = stoi(arg.substr(cpuThreadsPrefix.size()));
+            continue;
+        }
+        if (arg == "--counters") {
+            args.counters = true;
+            continue;
+        }
+        if (arg == "--tune") {
+            args.tuneRepeats = 10;
+            continue;
+        }
+        const string tunePrefix = "--tune=";
+        if (arg.rfind(tunePrefix, 0) == 0) {
+            args.tuneRepeats = stoi(arg.substr(tunePrefix.size()));
+            continue;
+        }
+        const string wisdomPrefix = "--wisdom=";
+        if (arg.rfind(wisdomPrefix, 0) == 0) {
+            args.wisdomPath = arg.substr(wisdomPrefix.size());
+            continue;
+        }
+        const string tracePrefix = "--trace=";
+        if (arg.rfind(tracePrefix, 0) == 0) {
+            args.tracePath = arg.substr(tracePrefix.size());
+            continue;
+        }
+        const string blockRowsPrefix = "--row-blocks=";
+        if (arg.rfind(blockRowsPrefix, 0) == 0) {
+            args.blockRows = stoi(arg.substr(blockRowsPrefix.size()));
+            continue;
+        }
         const string benchmarkPrefix = "--benchmark=";
         if (arg.rfind(benchmarkPrefix, 0) == 0) {
             args.benchmarkRepeats = stoi(arg.substr(benchmarkPrefix.size()));
@@ -50,13 +230,127 @@ ParsedArgs parseArgs(int argc, char* argv[]) {
     return args;
 }
 
-vector<complex<float>> flattenMatrix(const vector<vector<complex<float>>>& input) {
-    vector<complex<float>> flatInput;
-    flatInput.reserve(input.size() * input.front().size());
-    for (const auto& row : input) {
-        flatInput.insert(flatInput.end(), row.begin(), row.end());
+// Text format: "rows cols" followed by rows * cols "re im" pairs
+bool loadTextMatrix(const string& path, vector<complex<float>>& values, MatrixView& view) {
+    ifstream infile(path);
+    if (!infile) {
+        cerr << "Failed to open " << path << endl;
+        return false;
+    }
+
+    int rows, cols;
+    infile >> rows >> cols;
+    values.resize(size_t(rows) * size_t(cols));
+    for (complex<float>& value : values) {
+        float re, im;
+        infile >> re >> im;
+        value = {re, im};
     }
-    return flatInput;
+
+    view.rows = rows;
+    view.cols = cols;
+    view.dtype = MatrixDtype::Complex64;
+    view.data = values.data();
+    view.bytes = sizeof(complex<float>) * values.size();
+    return true;
+}
+
+// Loads a raw matrix or .npy file straight from its mapping, or falls back to the text format
+bool loadInput(const string& path, MappedFile& mapped, vector<complex<float>>& textValues, MatrixView& view) {
+    if (!mapFile(path, mapped)) {
+        return false;
+    }
+    if (isMatrixFile(mapped)) {
+        return parseMatrixFile(mapped, view);
+    }
+    if (isNpyFile(mapped)) {
+        return parseNpyFile(mapped, view);
+    }
+    unmapFile(mapped);
+    return loadTextMatrix(path, textValues, view);
+}
+
+// Returns the input in the storage format's element type, converting into a scratch vector only
+// when its dtype differs
+const void* inputInStorageFormat(const MatrixView& input, StorageFormat storage, vector<float>& floats, vector<uint16_t>& halves) {
+    const size_t scalars = 2 * size_t(input.rows) * size_t(input.cols);
+    const bool inputIsHalf = input.dtype == MatrixDtype::Complex32;
+
+    if (inputIsHalf == (storage == StorageFormat::Float16)) {
+        return input.data;
+    }
+    if (inputIsHalf) {
+        const uint16_t* source = static_cast<const uint16_t*>(input.data);
+        floats.resize(scalars);
+        transform(source, source + scalars, floats.begin(), halfToFloat);
+        return floats.data();
+    }
+    const float* source = static_cast<const float*>(input.data);
+    halves.resize(scalars);
+    transform(source, source + scalars, halves.begin(), floatToHalf);
+    return halves.data();
+}
+
+// Uploads the input, converting only when its dtype differs from the storage format
+wgpu::Buffer createInputBuffer(WebGPUContext& context, const MatrixView& input, StorageFormat storage) {
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    vector<float> floats;
+    vector<uint16_t> halves;
+    const void* data = inputInStorageFormat(input, storage, floats, halves);
+    return createBuffer(context, data, complexElementSize(storage) * size_t(input.rows) * size_t(input.cols), usage);
+}
+
+// Reads back a transform result as interleaved floats regardless of its storage format; empty on failure
+vector<float> readBackComplex(WebGPUContext& context, wgpu::Buffer& buffer, size_t total, StorageFormat storage) {
+    if (storage == StorageFormat::Float32) {
+        return readBack(context, 2 * total, buffer);
+    }
+    const vector<uint16_t> halves = readBackHalf(context, 2 * total, buffer);
+    vector<float> output(halves.size());
+    transform(halves.begin(), halves.end(), output.begin(), halfToFloat);
+    return output;
+}
+
+// Runs one direction of the transform into `output`, whether the input is already resident on the
+// device or streamed in row blocks
+using TransformInto = function<void(wgpu::Buffer& output, uint32_t doInverse)>;
+
+// Queues every direction before reading any back, then awaits all readbacks together so the
+// host never blocks between transforms. Results are returned as interleaved floats.
+vector<vector<float>> runDirections(
+    WebGPUContext& context,
+    const TransformInto& transformInto,
+    const vector<uint32_t>& directions,
+    int rows,
+    int cols,
+    const TransformOptions& options
+) {
+    const size_t total = size_t(rows) * size_t(cols);
+    const size_t bytes = complexElementSize(options.storage) * total;
+
+    vector<wgpu::Buffer> resultBuffers;
+    for (uint32_t doInverse : directions) {
+        resultBuffers.push_back(createBuffer(context, nullptr, bytes,
+            WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc)));
+        transformInto(resultBuffers.back(), doInverse);
+    }
+
+    vector<vector<float>> outputs(directions.size(), vector<float>(2 * total));
+    vector<vector<uint16_t>> halves(options.storage == StorageFormat::Float16 ? directions.size() : 0, vector<uint16_t>(2 * total));
+    vector<AsyncJob> jobs;
+    for (size_t index = 0; index < directions.size(); ++index) {
+        void* destination = halves.empty() ? static_cast<void*>(outputs[index].data()) : halves[index].data();
+        jobs.push_back(readBackAsync(context, resultBuffers[index], destination, bytes));
+    }
+    waitForJobs(context, jobs);
+
+    for (size_t index = 0; index < halves.size(); ++index) {
+        transform(halves[index].begin(), halves[index].end(), outputs[index].begin(), halfToFloat);
+    }
+    for (wgpu::Buffer& buffer : resultBuffers) {
+        releaseBuffer(context, buffer);
+    }
+    return outputs;
 }
 
 void printMatrix(const vector<float>& buffer, int rows, int cols) {
@@ -72,36 +366,85 @@ void printMatrix(const vector<float>& buffer, int rows, int cols) {
     }
 }
 
+// Runs each direction and streams the results into one complex64 .npy file: (rows, cols), or
+// (2, rows, cols) holding forward then inverse. f32 results are written straight from the mapped
+// readback range; f16 results are widened on the host first.
+bool writeNpyOutput(
+    WebGPUContext& context,
+    const string& path,
+    const TransformInto& transformInto,
+    const vector<uint32_t>& directions,
+    int rows,
+    int cols,
+    const TransformOptions& options
+) {
+    const int fd = openOutputFile(path);
+    if (fd < 0) {
+        return false;
+    }
+
+    const size_t total = size_t(rows) * size_t(cols);
+    vector<size_t> shape = {size_t(rows), size_t(cols)};
+    if (directions.size() > 1) {
+        shape.insert(shape.begin(), directions.size());
+    }
+    const string header = makeNpyHeader(shape);
+    bool written = writeToFile(fd, header.data(), header.size());
+
+    for (uint32_t doInverse : directions) {
+        wgpu::Buffer resultBuffer = createBuffer(context, nullptr, complexElementSize(options.storage) * total,
+            WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
+        transformInto(resultBuffer, doInverse);
+        if (options.storage == StorageFormat::Float32) {
+            const bool mapped = readBackMapped(context, sizeof(float) * 2 * total, resultBuffer, [&](const void* data, size_t size) {
+                written = written && writeToFile(fd, data, size);
+            });
+            written = written && mapped;
+        } else {
+            const vector<float> values = readBackComplex(context, resultBuffer, total, options.storage);
+            written = written && !values.empty() && writeToFile(fd, values.data(), sizeof(float) * values.size());
+        }
+        releaseBuffer(context, resultBuffer);
+    }
+
+    closeOutputFile(fd);
+    return written;
+}
+
+void printBenchmark(const vector<double>& durationsMs);
+
 void runBenchmark(
     WebGPUContext& context,
-    wgpu::Buffer& inputBuffer,
-    size_t buffersize,
+    const TransformInto& transformInto,
     int rows,
     int cols,
     uint32_t doInverse,
-    bool forceDft,
+    const TransformOptions& options,
     int repeats
 ) {
     vector<double> durationsMs;
     durationsMs.reserve(repeats);
 
     wgpu::Buffer outputBuffer = createBuffer(
-        context.device,
+        context,
         nullptr,
-        sizeof(float) * 2 * rows * cols,
+        complexElementSize(options.storage) * rows * cols,
         WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc)
     );
 
     for (int iteration = 0; iteration < repeats; ++iteration) {
         const auto start = chrono::steady_clock::now();
-        fft(context, outputBuffer, inputBuffer, buffersize, rows, cols, doInverse, forceDft);
+        transformInto(outputBuffer, doInverse);
         waitForQueueIdle(context.device, context.queue);
         const auto end = chrono::steady_clock::now();
         durationsMs.push_back(chrono::duration<double, std::milli>(end - start).count());
     }
 
-    outputBuffer.release();
+    releaseBuffer(context, outputBuffer);
+    printBenchmark(durationsMs);
+}
 
+void printBenchmark(const vector<double>& durationsMs) {
     double sumMs = 0.0;
     double minMs = numeric_limits<double>::max();
     double maxMs = 0.0;
@@ -122,91 +465,539 @@ void runBenchmark(
     cout << "\n";
 }
 
+// Prints every tuning candidate, fastest first; the first line is the plan fft() will use
+void printTuning(const vector<TunedPlan>& plans) {
+    cout << "tune\n";
+    for (const TunedPlan& plan : plans) {
+        cout << (plan.useDft ? "dft" : "fft") << " " << plan.workgroupX << "x" << plan.workgroupY << " " << plan.milliseconds << "\n";
+    }
+}
+
+// Times every pass of one transform with GPU timestamp queries and reports each pass against the
+// device's probed peak bandwidth. A warm-up run first creates and caches the pipelines, although
+// timestamps exclude host-side work either way.
+bool runProfile(
+    WebGPUContext& context,
+    const TransformInto& transformInto,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options
+) {
+    wgpu::Buffer outputBuffer = createBuffer(
+        context,
+        nullptr,
+        complexElementSize(options.storage) * rows * cols,
+        WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc)
+    );
+    transformInto(outputBuffer, doInverse);
+    waitForQueueIdle(context.device, context.queue);
+
+    // The bandwidth probe needs the profiler itself, so it runs before the profile starts
+    measureDeviceBandwidth(context);
+    if (!beginProfiling(context)) {
+        releaseBuffer(context, outputBuffer);
+        return false;
+    }
+    transformInto(outputBuffer, doInverse);
+    const vector<PassTiming> timings = endProfiling(context);
+    releaseBuffer(context, outputBuffer);
+
+    double totalMs = 0.0;
+    for (const PassTiming& timing : timings) {
+        totalMs += timing.milliseconds;
+    }
+    cout << "profile\n";
+    printRoofline(timings, context.bandwidth);
+    cout << "total_gpu_ms " << totalMs << "\n";
+    return true;
+}
+
+// Streams the same input as every frame and reports sustained throughput and stage occupancy
+void runStreaming(
+    WebGPUContext& context,
+    const void* frameData,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int frames,
+    int slots
+) {
+    const StreamStats stats = runStream(
+        context,
+        rows,
+        cols,
+        doInverse,
+        options,
+        frames,
+        slots,
+        [&](int) { return frameData; },
+        [](int, const void*, size_t) {}
+    );
+
+    cout << "stream\n";
+    cout << "frames " << stats.frames << "\n";
+    cout << "slots " << max(slots, 1) << "\n";
+    cout << "seconds " << stats.seconds << "\n";
+    cout << "fps " << stats.framesPerSecond << "\n";
+    cout << "upload_occupancy " << stats.uploadOccupancy << "\n";
+    cout << "compute_occupancy " << stats.computeOccupancy << "\n";
+    cout << "download_occupancy " << stats.downloadOccupancy << "\n";
+}
+
+// Sends the input from `requests` concurrent client threads through a RequestCoalescer, and reports how
+// the requests were batched and how far any result strays from a direct fft() of the input.
+// Returns false if the reference transform or any request failed.
+bool runCoalesced(WebGPUContext& context, const MatrixView& input, uint32_t doInverse, const TransformOptions& options, int requests, int windowUs) {
+    const size_t total = size_t(input.rows) * size_t(input.cols);
+    vector<float> floats;
+    vector<uint16_t> halves;
+    const auto* matrix = static_cast<const complex<float>*>(inputInStorageFormat(input, StorageFormat::Float32, floats, halves));
+    TransformOptions f32Options = options;
+    f32Options.storage = StorageFormat::Float32;
+
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    wgpu::Buffer inputBuffer = createBuffer(context, matrix, 2 * sizeof(float) * total, usage);
+    wgpu::Buffer outputBuffer = createBuffer(context, nullptr, 2 * sizeof(float) * total, usage);
+    fft(context, outputBuffer, inputBuffer, total, input.rows, input.cols, doInverse, f32Options);
+    const vector<float> reference = readBack(context, 2 * total, outputBuffer);
+    releaseBuffer(context, inputBuffer);
+    releaseBuffer(context, outputBuffer);
+    if (reference.empty()) {
+        cerr << "Failed to read back the reference transform" << endl;
+        return false;
+    }
+
+    vector<vector<complex<float>>> outputs(static_cast<size_t>(requests), vector<complex<float>>(total));
+    atomic<int> failures{0};
+    CoalescerStats stats;
+    const auto start = chrono::steady_clock::now();
+    {
+        RequestCoalescer coalescer(context, chrono::microseconds(windowUs));
+        vector<thread> clients;
+        for (int request = 0; request < requests; ++request) {
+            clients.emplace_back([&, request]() {
+                try {
+                    coalescer.transform(outputs[size_t(request)].data(), matrix, input.rows, input.cols, doInverse, f32Options);
+                } catch (const exception& error) {
+                    cerr << "Coalesced request " << request << " failed: " << error.what() << endl;
+                    ++failures;
+                }
+            });
+        }
+        for (thread& client : clients) {
+            client.join();
+        }
+        stats = coalescer.stats();
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double maxDifference = 0.0;
+    for (const vector<complex<float>>& output : outputs) {
+        for (size_t index = 0; index < total; ++index) {
+            const complex<float> expected(reference[2 * index], reference[2 * index + 1]);
+            maxDifference = max(maxDifference, double(abs(output[index] - expected)));
+        }
+    }
+
+    cout << "coalesce\n";
+    cout << "requests " << stats.requests << "\n";
+    cout << "batches " << stats.batches << "\n";
+    cout << "largest_batch " << stats.largestBatch << "\n";
+    cout << "seconds " << seconds << "\n";
+    cout << "transforms_per_second " << (seconds > 0.0 ? requests / seconds : 0.0) << "\n";
+    cout << "max_difference " << maxDifference << "\n";
+    return failures == 0;
+}
+
+// Transforms a batch of copies of the input split between the GPU and the CPU engine, and reports the split
+void runHybrid(
+    WebGPUContext& context,
+    const MatrixView& input,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int batch,
+    int slots,
+    int cpuThreads
+) {
+    const size_t total = size_t(input.rows) * size_t(input.cols);
+    vector<float> floats;
+    vector<uint16_t> halves;
+    const auto* matrix = static_cast<const complex<float>*>(inputInStorageFormat(input, StorageFormat::Float32, floats, halves));
+    vector<complex<float>> inputs(size_t(batch) * total);
+    for (int index = 0; index < batch; ++index) {
+        copy(matrix, matrix + total, inputs.begin() + size_t(index) * total);
+    }
+    vector<complex<float>> outputs(inputs.size());
+
+    // One hardware thread stays free to drive the GPU
+    CpuContext cpu;
+    initCpu(cpu, cpuThreads > 0 ? unsigned(cpuThreads) : max(2u, thread::hardware_concurrency()) - 1);
+    HybridScheduler scheduler;
+    scheduler.gpuSlots = slots;
+    const HybridStats stats = runHybridBatch(context, cpu, scheduler, outputs.data(), inputs.data(), batch, input.rows, input.cols, doInverse, options);
+
+    cout << "hybrid\n";
+    cout << "transforms " << batch << "\n";
+    cout << "gpu_transforms " << stats.gpuTransforms << "\n";
+    cout << "cpu_transforms " << stats.cpuTransforms << "\n";
+    cout << "seconds " << stats.seconds << "\n";
+    cout << "transforms_per_second " << stats.transformsPerSecond << "\n";
+    cout << "gpu_seconds " << stats.gpuSeconds << "\n";
+    cout << "cpu_seconds " << stats.cpuSeconds << "\n";
+}
+
+// Transforms a batch of copies of the input spread over every WebGPU adapter, and reports each device's share
+int runMultiGpu(const ParsedArgs& args, const MatrixView& input) {
+    MultiGpuContext context;
+    if (!initMultiGpu(context, args.allAdapters ? AdapterSelection::All : AdapterSelection::Hardware)) {
+        releaseMultiGpu(context);
+        return -1;
+    }
+    const size_t total = size_t(input.rows) * size_t(input.cols);
+    vector<float> floats;
+    vector<uint16_t> halves;
+    const auto* matrix = static_cast<const complex<float>*>(inputInStorageFormat(input, StorageFormat::Float32, floats, halves));
+    vector<complex<float>> inputs(size_t(args.multiGpuBatch) * total);
+    for (int index = 0; index < args.multiGpuBatch; ++index) {
+        copy(matrix, matrix + total, inputs.begin() + size_t(index) * total);
+    }
+    vector<complex<float>> outputs(inputs.size());
+
+    const uint32_t doInverse = args.mode == TransformMode::Backward ? 1 : 0;
+    const MultiGpuStats stats = runMultiGpuBatch(context, outputs.data(), inputs.data(), args.multiGpuBatch, input.rows, input.cols, doInverse, args.options, 4, args.streamSlots);
+
+    cout << "multi_gpu\n";
+    cout << "devices " << context.devices.size() << "\n";
+    cout << "transforms " << args.multiGpuBatch << "\n";
+    cout << "seconds " << stats.seconds << "\n";
+    cout << "transforms_per_second " << stats.transformsPerSecond << "\n";
+    for (size_t device = 0; device < context.devices.size(); ++device) {
+        cout << "device " << device << " transforms " << stats.transforms[device] << " steals " << stats.steals[device]
+             << " adapter " << context.devices[device]->adapterName << "\n";
+    }
+    releaseMultiGpu(context);
+    return 0;
+}
+
+int writeHostOutputs(const ParsedArgs& args, int rows, int cols, const vector<vector<float>>& outputs);
+
+// Keeps one device warm and serves transform jobs on the socket until a client asks it to stop
+int runServerMode(const ParsedArgs& args) {
+    WebGPUContext context;
+    if (!initWebGPU(context)) {
+        releaseWebGPU(context);
+        return -1;
+    }
+    if (!args.wisdomPath.empty()) {
+        loadWisdom(context, args.wisdomPath);
+    }
+    const bool served = runServer(context, args.socketPath, args.options, uint64_t(max(args.cacheMegabytes, 0)) << 20);
+    if (args.counters) {
+        printCounters(cout, context.counters);
+    }
+    releaseWebGPU(context);
+    return served ? 0 : -1;
+}
+
+// Runs the requested directions as a slab-decomposed transform over every adapter. Each device only
+// holds one slab at a time, so the matrix may exceed a single device's buffer limit.
+int runDistributed(const ParsedArgs& args, const MatrixView& input, const vector<uint32_t>& directions) {
+    MultiGpuContext context;
+    if (!initMultiGpu(context, args.allAdapters ? AdapterSelection::All : AdapterSelection::Hardware)) {
+        releaseMultiGpu(context);
+        return -1;
+    }
+    const size_t total = size_t(input.rows) * size_t(input.cols);
+    vector<float> floats;
+    vector<uint16_t> halves;
+    const auto* data = static_cast<const complex<float>*>(inputInStorageFormat(input, StorageFormat::Float32, floats, halves));
+
+    bool transformed = true;
+    vector<vector<float>> outputs(directions.size(), vector<float>(2 * total));
+    for (size_t index = 0; index < directions.size() && transformed; ++index) {
+        transformed = distributedFft(context, reinterpret_cast<complex<float>*>(outputs[index].data()), data,
+            input.rows, input.cols, directions[index], args.options, args.slabs);
+    }
+    releaseMultiGpu(context);
+    return transformed ? writeHostOutputs(args, input.rows, input.cols, outputs) : -1;
+}
+
+// Runs the requested directions on the CPU engine, for hosts without a usable WebGPU device or
+// when --cpu is given. Results go to the same text, .npy or benchmark output as the GPU path.
+int runCpu(const ParsedArgs& args, const MatrixView& input, const vector<uint32_t>& directions) {
+    if (args.streamFrames > 0 || args.hybridBatch > 0 || args.coalesceRequests > 0 || args.profile || args.blockRows > 0 || args.inPlace || args.tuneRepeats > 0) {
+        cerr << "--stream, --hybrid, --coalesce, --profile, --row-blocks, --in-place and --tune need a WebGPU device" << endl;
+        return -1;
+    }
+    const int rows = input.rows;
+    const int cols = input.cols;
+    const size_t total = size_t(rows) * size_t(cols);
+
+    CpuContext cpu;
+    initCpu(cpu, unsigned(max(args.cpuThreads, 0)));
+    vector<float> floats;
+    vector<uint16_t> halves;
+    const auto* data = static_cast<const complex<float>*>(inputInStorageFormat(input, StorageFormat::Float32, floats, halves));
+
+    if (args.benchmarkRepeats > 0) {
+        const uint32_t doInverse = args.mode == TransformMode::Backward ? 1 : 0;
+        vector<complex<float>> output(total);
+        vector<double> durationsMs;
+        for (int iteration = 0; iteration < args.benchmarkRepeats; ++iteration) {
+            const auto start = chrono::steady_clock::now();
+            cpuFft(cpu, output.data(), data, rows, cols, doInverse, args.options);
+            durationsMs.push_back(chrono::duration<double, std::milli>(chrono::steady_clock::now() - start).count());
+        }
+        printBenchmark(durationsMs);
+        return 0;
+    }
+
+    vector<vector<float>> outputs(directions.size(), vector<float>(2 * total));
+    for (size_t index = 0; index < directions.size(); ++index) {
+        cpuFft(cpu, reinterpret_cast<complex<float>*>(outputs[index].data()), data, rows, cols, directions[index], args.options);
+    }
+    return writeHostOutputs(args, rows, cols, outputs);
+}
+
+// Writes one host result per direction to the .npy file, or prints them as text
+int writeHostOutputs(const ParsedArgs& args, int rows, int cols, const vector<vector<float>>& outputs) {
+    if (!args.outputPath.empty()) {
+        const int fd = openOutputFile(args.outputPath);
+        if (fd < 0) {
+            return -1;
+        }
+        vector<size_t> shape = {size_t(rows), size_t(cols)};
+        if (outputs.size() > 1) {
+            shape.insert(shape.begin(), outputs.size());
+        }
+        const string header = makeNpyHeader(shape);
+        bool written = writeToFile(fd, header.data(), header.size());
+        for (const vector<float>& output : outputs) {
+            written = written && writeToFile(fd, output.data(), sizeof(float) * output.size());
+        }
+        closeOutputFile(fd);
+        return written ? 0 : -1;
+    }
+
+    cout << rows << " " << cols << "\n";
+    for (const vector<float>& output : outputs) {
+        printMatrix(output, rows, cols);
+    }
+    return 0;
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
     const ParsedArgs args = parseArgs(argc, argv);
 
-    ifstream infile("tests/artifacts/input.txt");
-    if (!infile) {
-        cerr << "Failed to open input.txt" << endl;
+    // Served jobs bring their own matrices, so no input file is loaded
+    if (!args.socketPath.empty()) {
+        return runServerMode(args);
+    }
+
+    MappedFile mappedInput;
+    vector<complex<float>> textInput;
+    MatrixView input;
+    if (!loadInput(args.inputPath, mappedInput, textInput, input)) {
         return -1;
     }
+    const int rows = input.rows;
+    const int cols = input.cols;
+    const int total = rows * cols;
 
-    int rows, cols;
-    infile >> rows >> cols;
-    vector<vector<complex<float>>> input(rows, vector<complex<float>>(cols));
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            float re, im;
-            infile >> re >> im;
-            input[i][j] = {re,im};
-        }
+    // A dense DFT has no in-place form for a vector, so only power-of-two vectors can use --in-place
+    if (args.inPlace && (rows < 2 || cols < 2) && (args.options.forceDft || !isValidFFTDimensions(rows, cols))) {
+        cerr << "--in-place needs at least 2 rows and 2 columns unless the vector length is a power of two and the DFT is not forced" << endl;
+        unmapFile(mappedInput);
+        return -1;
     }
-    infile.close();
 
-    vector<complex<float>> flatInput = flattenMatrix(input);
+    vector<uint32_t> directions;
+    if (args.mode == TransformMode::Both || args.mode == TransformMode::Forward) {
+        directions.push_back(0);
+    }
+    if (args.mode == TransformMode::Both || args.mode == TransformMode::Backward) {
+        directions.push_back(1);
+    }
+
+    // Multi-device batches and distributed transforms open their own context per adapter
+    if (args.multiGpuBatch > 0 || args.slabs >= 0) {
+        const int status = args.multiGpuBatch > 0 ? runMultiGpu(args, input) : runDistributed(args, input, directions);
+        unmapFile(mappedInput);
+        return status;
+    }
 
+    // Without a device (e.g. a headless node) the CPU engine takes over
     WebGPUContext context;
-    initWebGPU(context);
+    if (args.cpu || !initWebGPU(context)) {
+        if (!args.cpu) {
+            cerr << "WebGPU is unavailable; falling back to the CPU engine" << endl;
+        }
+        const int status = runCpu(args, input, directions);
+        unmapFile(mappedInput);
+        releaseWebGPU(context);
+        return status;
+    }
 
-    const int total = rows * cols;
-    wgpu::Buffer inputBuffer = createBuffer(context.device, flatInput.data(), sizeof(float) * 2 * flatInput.size(), 
-        WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
+    TransformOptions options = args.options;
+    if (options.storage == StorageFormat::Float16 && !context.supportsF16) {
+        cerr << "shader-f16 is not supported by this adapter, falling back to f32 storage" << endl;
+        options.storage = StorageFormat::Float32;
+    }
+
+    // Host spans are recorded from here on; GPU passes are timestamped too unless --profile owns the profiler
+    const bool tracing = !args.tracePath.empty() && traceAvailable();
+    if (!args.tracePath.empty() && !tracing) {
+        cerr << "Tracing is not compiled in; rebuild with -DWGPU_DFT_TRACING=ON to use --trace" << endl;
+    }
+    if (tracing) {
+        traceStart();
+        if (!args.profile && context.supportsTimestamps) {
+            beginProfiling(context);
+        }
+    }
+    auto finishDiagnostics = [&]() {
+        if (tracing) {
+            endProfiling(context);
+            traceWrite(args.tracePath);
+        }
+        if (args.counters) {
+            printCounters(cout, context.counters);
+        }
+    };
+
+    // A missing wisdom file is not an error: --tune creates it
+    if (!args.wisdomPath.empty()) {
+        loadWisdom(context, args.wisdomPath);
+    }
+
+    if (args.tuneRepeats > 0) {
+        printTuning(tuneTransform(context, rows, cols, options, args.tuneRepeats));
+        const bool saved = args.wisdomPath.empty() || saveWisdom(context, args.wisdomPath);
+
+        finishDiagnostics();
+        unmapFile(mappedInput);
+        releaseWebGPU(context);
+        return saved ? 0 : -1;
+    }
+
+    // Streaming re-uploads the input as every frame, so it keeps the host copy for the whole run
+    if (args.streamFrames > 0) {
+        vector<float> floats;
+        vector<uint16_t> halves;
+        const void* frameData = inputInStorageFormat(input, options.storage, floats, halves);
+        const uint32_t doInverse = args.mode == TransformMode::Backward ? 1 : 0;
+        runStreaming(context, frameData, rows, cols, doInverse, options, args.streamFrames, args.streamSlots);
+
+        finishDiagnostics();
+        unmapFile(mappedInput);
+        releaseWebGPU(context);
+        return 0;
+    }
+
+    if (args.coalesceRequests > 0) {
+        const uint32_t doInverse = args.mode == TransformMode::Backward ? 1 : 0;
+        const bool coalesced = runCoalesced(context, input, doInverse, options, args.coalesceRequests, args.coalesceWindowUs);
+
+        finishDiagnostics();
+        unmapFile(mappedInput);
+        releaseWebGPU(context);
+        return coalesced ? 0 : -1;
+    }
+
+    if (args.hybridBatch > 0) {
+        const uint32_t doInverse = args.mode == TransformMode::Backward ? 1 : 0;
+        runHybrid(context, input, doInverse, options, args.hybridBatch, args.streamSlots, args.cpuThreads);
+
+        finishDiagnostics();
+        unmapFile(mappedInput);
+        releaseWebGPU(context);
+        return 0;
+    }
+
+    // Row-block and in-place modes read the input from the mapping for every transform, so it stays
+    // mapped; otherwise the mapping (or parsed text) is only needed until the upload is queued
+    wgpu::Buffer inputBuffer = nullptr;
+    vector<float> blockFloats;
+    vector<uint16_t> blockHalves;
+    TransformInto transformInto;
+    if (args.blockRows > 0) {
+        const size_t inputRowBytes = size_t(cols) * matrixDtypeSize(input.dtype);
+        const RowBlockSource source = [&](int firstRow, int rowCount) {
+            MatrixView block = input;
+            block.rows = rowCount;
+            block.data = static_cast<const unsigned char*>(input.data) + size_t(firstRow) * inputRowBytes;
+            block.bytes = size_t(rowCount) * inputRowBytes;
+            return inputInStorageFormat(block, options.storage, blockFloats, blockHalves);
+        };
+        transformInto = [&, source](wgpu::Buffer& output, uint32_t doInverse) {
+            fftStreamedRows(context, output, rows, cols, doInverse, options, source, args.blockRows);
+        };
+    } else if (args.inPlace) {
+        // The input stays on the host and is uploaded into each result buffer, which is then transformed in place
+        const void* hostInput = inputInStorageFormat(input, options.storage, blockFloats, blockHalves);
+        const size_t bytes = complexElementSize(options.storage) * size_t(total);
+        transformInto = [&, hostInput, bytes](wgpu::Buffer& output, uint32_t doInverse) {
+            writeBuffer(context, output, 0, hostInput, bytes);
+            fftInPlace(context, output, rows, cols, doInverse, options);
+        };
+    } else {
+        inputBuffer = createInputBuffer(context, input, options.storage);
+        unmapFile(mappedInput);
+        textInput = {};
+        transformInto = [&](wgpu::Buffer& output, uint32_t doInverse) {
+            fft(context, output, inputBuffer, total, rows, cols, doInverse, options);
+        };
+    }
+    auto release = [&]() {
+        finishDiagnostics();
+        if (inputBuffer) {
+            releaseBuffer(context, inputBuffer);
+        }
+        unmapFile(mappedInput);
+        releaseWebGPU(context);
+    };
+
+    if (args.profile) {
+        const uint32_t doInverse = args.mode == TransformMode::Backward ? 1 : 0;
+        const bool profiled = runProfile(context, transformInto, rows, cols, doInverse, options);
+        release();
+        return profiled ? 0 : -1;
+    }
 
     if (args.benchmarkRepeats > 0) {
         const uint32_t doInverse = args.mode == TransformMode::Backward ? 1 : 0;
         runBenchmark(
             context,
-            inputBuffer,
-            flatInput.size(),
+            transformInto,
             rows,
             cols,
             doInverse,
-            args.forceDft,
+            options,
             args.benchmarkRepeats
         );
 
-        wgpuQueueRelease(context.queue);
-        wgpuDeviceRelease(context.device);
-        wgpuAdapterRelease(context.adapter);
-        wgpuInstanceRelease(context.instance);
-        inputBuffer.release();
+        release();
         return 0;
     }
 
-    vector<float> forwardOutput;
-    vector<float> inverseOutput;
-
-    if (args.mode == TransformMode::Both || args.mode == TransformMode::Forward) {
-        wgpu::Buffer forwardBuffer = createBuffer(context.device, nullptr, sizeof(float) * 2 * total,
-            WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
-        fft(context, forwardBuffer, inputBuffer, flatInput.size(), rows, cols, 0, args.forceDft);
-        forwardOutput = readBack(context.device, context.queue, 2 * total, forwardBuffer);
-        forwardBuffer.release();
+    if (!args.outputPath.empty()) {
+        const bool written = writeNpyOutput(context, args.outputPath, transformInto, directions, rows, cols, options);
+        release();
+        return written ? 0 : -1;
     }
 
-    if (args.mode == TransformMode::Both || args.mode == TransformMode::Backward) {
-        wgpu::Buffer inverseBuffer = createBuffer(context.device, nullptr, sizeof(float) * 2 * total,
-            WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc));
-        fft(context, inverseBuffer, inputBuffer, flatInput.size(), rows, cols, 1, args.forceDft);
-        inverseOutput = readBack(context.device, context.queue, 2 * total, inverseBuffer);
-        inverseBuffer.release();
-    }
+    const vector<vector<float>> outputs = runDirections(context, transformInto, directions, rows, cols, options);
 
     cout << rows << " " << cols << "\n";
-    if (args.mode == TransformMode::Both || args.mode == TransformMode::Forward) {
-        printMatrix(forwardOutput, rows, cols);
-    }
-    if (args.mode == TransformMode::Both || args.mode == TransformMode::Backward) {
-        printMatrix(inverseOutput, rows, cols);
+    for (const vector<float>& output : outputs) {
+        printMatrix(output, rows, cols);
     }
 
-    wgpuQueueRelease(context.queue);
-    wgpuDeviceRelease(context.device);
-    wgpuAdapterRelease(context.adapter);
-    wgpuInstanceRelease(context.instance);
-    inputBuffer.release();
+    release();
 
     return 0;
 }
@@ -0,0 +1,156 @@
+#include "distributed.h"
+#include "../fft/fft.h"
+#include "../profile/trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using Complex = std::complex<float>;
+
+// Fills a host slab with lines [first, first + count) of a pass, each `length` elements long
+using SlabGather = std::function<void(int first, int count, Complex* slab)>;
+// Takes the transformed lines [first, first + count) of a pass back
+using SlabScatter = std::function<void(int first, int count, const Complex* slab)>;
+
+// Largest slab every device can allocate and bind as one storage buffer
+static uint64_t maxSlabBytes(MultiGpuContext& context) {
+    uint64_t limit = UINT64_MAX;
+    for (const std::unique_ptr<WebGPUContext>& device : context.devices) {
+        WGPUSupportedLimits limits = {};
+        wgpuDeviceGetLimits(device->device, &limits);
+        limit = std::min({limit, limits.limits.maxBufferSize, limits.limits.maxStorageBufferBindingSize});
+    }
+    return limit;
+}
+
+// First line of slab `slab` when `lines` lines are cut into `slabs` near-equal slabs
+static int slabStart(int lines, int slabs, int slab) {
+    return int(int64_t(lines) * slab / slabs);
+}
+
+// Transforms `lines` lines of `length` elements as `slabs` slabs, one host thread per device.
+// Returns false if any slab could not be read back.
+static bool runSlabPass(
+    MultiGpuContext& context,
+    int lines,
+    int length,
+    int slabs,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    const SlabGather& gather,
+    const SlabScatter& scatter
+) {
+    const int deviceCount = int(context.devices.size());
+    const size_t capacity = size_t((lines + slabs - 1) / slabs) * size_t(length);
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst);
+
+    std::atomic<bool> readBackFailed{false};
+    std::vector<std::thread> workers;
+    for (int device = 0; device < deviceCount; ++device) {
+        workers.emplace_back([&, device]() {
+            WebGPUContext& gpu = *context.devices[device];
+            std::vector<Complex> host(capacity);
+            wgpu::Buffer inputBuffer = createBuffer(gpu, nullptr, capacity * sizeof(Complex), usage);
+            wgpu::Buffer outputBuffer = createBuffer(gpu, nullptr, capacity * sizeof(Complex), usage);
+
+            for (int slab = device; slab < slabs; slab += deviceCount) {
+                const int first = slabStart(lines, slabs, slab);
+                const int count = slabStart(lines, slabs, slab + 1) - first;
+                if (count == 0) {
+                    continue;
+                }
+                const size_t bytes = size_t(count) * size_t(length) * sizeof(Complex);
+                gather(first, count, host.data());
+                writeBuffer(gpu, inputBuffer, 0, host.data(), bytes);
+                fftRows(gpu, outputBuffer, inputBuffer, count, length, doInverse, options);
+                const bool mapped = readBackMapped(gpu, bytes, outputBuffer, [&](const void* data, size_t) {
+                    scatter(first, count, static_cast<const Complex*>(data));
+                });
+                if (!mapped) {
+                    readBackFailed = true;
+                }
+            }
+
+            releaseBuffer(gpu, inputBuffer);
+            releaseBuffer(gpu, outputBuffer);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return !readBackFailed;
+}
+
+bool distributedFft(
+    MultiGpuContext& context,
+    Complex* output,
+    const Complex* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int slabs
+) {
+    TRACE_SCOPE("distributed fft");
+    if (context.devices.empty() || rows <= 0 || cols <= 0) {
+        return false;
+    }
+    TransformOptions gpuOptions = options;
+    gpuOptions.storage = StorageFormat::Float32;
+
+    // Both passes must fit: row slabs are (rows / slabs) x cols, column slabs (cols / slabs) x rows
+    const uint64_t limit = maxSlabBytes(context);
+    const int maxSlabs = std::min(rows, cols);
+    auto fits = [&](int count) {
+        return uint64_t((rows + count - 1) / count) * uint64_t(cols) * sizeof(Complex) <= limit
+            && uint64_t((cols + count - 1) / count) * uint64_t(rows) * sizeof(Complex) <= limit;
+    };
+    if (slabs <= 0) {
+        slabs = std::min(int(context.devices.size()), maxSlabs);
+        while (slabs < maxSlabs && !fits(slabs)) {
+            ++slabs;
+        }
+    }
+    slabs = std::min(slabs, maxSlabs);
+    if (!fits(slabs)) {
+        std::cerr << "A " << rows << "x" << cols << " matrix cannot be cut into slabs within the device buffer limit of "
+                  << limit << " bytes" << std::endl;
+        return false;
+    }
+
+    // Row pass: slabs of whole rows, written straight into the output
+    const size_t rowBytes = size_t(cols) * sizeof(Complex);
+    const bool rowsDone = runSlabPass(context, rows, cols, slabs, doInverse, gpuOptions,
+        [&](int first, int count, Complex* slab) {
+            std::memcpy(static_cast<void*>(slab), input + size_t(first) * cols, size_t(count) * rowBytes);
+        },
+        [&](int first, int count, const Complex* slab) {
+            std::memcpy(static_cast<void*>(output + size_t(first) * cols), slab, size_t(count) * rowBytes);
+        });
+    if (!rowsDone) {
+        return false;
+    }
+
+    // All-to-all transpose and column pass: each column slab is gathered transposed from the output,
+    // transformed as rows, and scattered back into the same columns
+    return runSlabPass(context, cols, rows, slabs, doInverse, gpuOptions,
+        [&](int first, int count, Complex* slab) {
+            for (int row = 0; row < rows; ++row) {
+                const Complex* source = output + size_t(row) * cols + first;
+                for (int col = 0; col < count; ++col) {
+                    slab[size_t(col) * rows + row] = source[col];
+                }
+            }
+        },
+        [&](int first, int count, const Complex* slab) {
+            for (int row = 0; row < rows; ++row) {
+                Complex* destination = output + size_t(row) * cols + first;
+                for (int col = 0; col < count; ++col) {
+                    destination[col] = slab[size_t(col) * rows + row];
+                }
+            }
+        });
+}
@@ -0,0 +1,26 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <complex>
+#include "multi_gpu.h"
+#include "../transform_options.h"
+
+// Slab-decomposed 2D transform of a host matrix too large for one device. The rows are cut into
+// `slabs` row slabs dealt round-robin to the devices, and each device transforms its slabs' rows one
+// slab at a time, so it never holds more than one slab. The all-to-all transpose goes through host
+// memory: the row-transformed slabs land in `output`, and the column pass takes column slabs from
+// it, transposed so columns become rows, transforms them the same way and writes them back.
+// slabs = 0 picks the fewest slabs, at least one per device, that fit every device's storage
+// binding limit. Returns false if no slab count fits or a slab readback fails. The GPU work uses f32 storage.
+bool distributedFft(
+    MultiGpuContext& context,
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int slabs = 0
+);
+
+#endif // DISTRIBUTED_H
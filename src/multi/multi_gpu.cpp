@@ -0,0 +1,192 @@
+#include "multi_gpu.h"
+#include "../stream/stream.h"
+#include <webgpu/wgpu.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+bool initMultiGpu(MultiGpuContext& context, AdapterSelection selection) {
+    wgpu::InstanceDescriptor instanceDescriptor = {};
+    context.instance = wgpu::createInstance(instanceDescriptor);
+    if (!context.instance) {
+        std::cerr << "Failed to create WebGPU instance." << std::endl;
+        return false;
+    }
+
+    // Primary backends only: secondary ones (GL) would list the same GPUs again
+    WGPUInstanceEnumerateAdapterOptions enumerateOptions = {};
+    enumerateOptions.backends = WGPUInstanceBackend_Primary;
+    std::vector<WGPUAdapter> adapters(wgpuInstanceEnumerateAdapters(context.instance, &enumerateOptions, nullptr));
+    wgpuInstanceEnumerateAdapters(context.instance, &enumerateOptions, adapters.data());
+
+    std::vector<bool> software(adapters.size());
+    bool anyHardware = false;
+    for (size_t index = 0; index < adapters.size(); ++index) {
+        WGPUAdapterProperties properties = {};
+        wgpuAdapterGetProperties(adapters[index], &properties);
+        software[index] = properties.adapterType == WGPUAdapterType_CPU;
+        anyHardware = anyHardware || !software[index];
+    }
+
+    for (size_t index = 0; index < adapters.size(); ++index) {
+        if (selection == AdapterSelection::Hardware && anyHardware && software[index]) {
+            wgpuAdapterRelease(adapters[index]);
+            continue;
+        }
+        // Every device context holds its own reference to the shared instance
+        std::unique_ptr<WebGPUContext> device(new WebGPUContext());
+        wgpuInstanceReference(context.instance);
+        device->instance = context.instance;
+        device->adapter = adapters[index];
+        if (!initWebGPUDevice(*device)) {
+            releaseWebGPU(*device);
+            continue;
+        }
+        context.devices.push_back(std::move(device));
+    }
+
+    if (context.devices.empty()) {
+        std::cerr << "No WebGPU adapter could be opened." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void releaseMultiGpu(MultiGpuContext& context) {
+    for (std::unique_ptr<WebGPUContext>& device : context.devices) {
+        releaseWebGPU(*device);
+    }
+    context.devices.clear();
+    if (context.instance) {
+        wgpuInstanceRelease(context.instance);
+        context.instance = nullptr;
+    }
+}
+
+// Matrices [next, end) not yet claimed by a device. Locks are never nested.
+struct WorkShare {
+    std::mutex mutex;
+    int next = 0;
+    int end = 0;
+};
+
+// Claims up to `count` matrices from the front of share `self`, refilling it with the back half of the
+// largest other share when it is empty. Returns how many were claimed (0 once no work is left anywhere).
+static int claimWork(std::vector<WorkShare>& shares, size_t self, int count, int& first, bool& stole) {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(shares[self].mutex);
+            const int remaining = shares[self].end - shares[self].next;
+            if (remaining > 0) {
+                first = shares[self].next;
+                const int claimed = std::min(count, remaining);
+                shares[self].next += claimed;
+                return claimed;
+            }
+        }
+
+        size_t victim = self;
+        int most = 0;
+        for (size_t other = 0; other < shares.size(); ++other) {
+            if (other == self) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(shares[other].mutex);
+            if (shares[other].end - shares[other].next > most) {
+                most = shares[other].end - shares[other].next;
+                victim = other;
+            }
+        }
+        if (most == 0) {
+            return 0;
+        }
+
+        // The victim may have shrunk since it was measured; an empty steal just looks again
+        int begin = 0;
+        int end = 0;
+        {
+            std::lock_guard<std::mutex> lock(shares[victim].mutex);
+            const int remaining = shares[victim].end - shares[victim].next;
+            end = shares[victim].end;
+            begin = end - (remaining + 1) / 2;
+            shares[victim].end = begin;
+        }
+        if (begin < end) {
+            std::lock_guard<std::mutex> lock(shares[self].mutex);
+            shares[self].next = begin;
+            shares[self].end = end;
+            stole = true;
+        }
+    }
+}
+
+MultiGpuStats runMultiGpuBatch(
+    MultiGpuContext& context,
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int chunk,
+    int slots
+) {
+    const size_t deviceCount = context.devices.size();
+    MultiGpuStats stats;
+    stats.transforms.assign(deviceCount, 0);
+    stats.steals.assign(deviceCount, 0);
+    if (deviceCount == 0 || batch <= 0) {
+        return stats;
+    }
+    TransformOptions gpuOptions = options;
+    gpuOptions.storage = StorageFormat::Float32;
+    const size_t total = size_t(rows) * size_t(cols);
+    chunk = std::max(chunk, 1);
+
+    std::vector<WorkShare> shares(deviceCount);
+    for (size_t device = 0; device < deviceCount; ++device) {
+        shares[device].next = int(batch * device / deviceCount);
+        shares[device].end = int(batch * (device + 1) / deviceCount);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t device = 0; device < deviceCount; ++device) {
+        workers.emplace_back([&, device]() {
+            // One open-ended stream per device keeps its slot buffers and pipeline full across claims;
+            // each frame is the next matrix of the current claim, and a new chunk is claimed once it runs out
+            WebGPUContext& gpu = *context.devices[device];
+            std::vector<int> matrixOfFrame;
+            int next = 0;
+            int end = 0;
+            runStream(gpu, rows, cols, doInverse, gpuOptions, -1, slots,
+                [&](int) -> const void* {
+                    if (next == end) {
+                        bool stole = false;
+                        const int count = claimWork(shares, device, chunk, next, stole);
+                        if (count == 0) {
+                            return nullptr;
+                        }
+                        end = next + count;
+                        stats.steals[device] += stole ? 1 : 0;
+                    }
+                    matrixOfFrame.push_back(next);
+                    return input + size_t(next++) * total;
+                },
+                [&](int frame, const void* data, size_t bytes) {
+                    std::memcpy(static_cast<void*>(output + size_t(matrixOfFrame[size_t(frame)]) * total), data, bytes);
+                    stats.transforms[device]++;
+                });
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.transformsPerSecond = stats.seconds > 0.0 ? batch / stats.seconds : 0.0;
+    return stats;
+}
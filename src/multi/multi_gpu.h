@@ -0,0 +1,54 @@
+#ifndef MULTI_GPU_H
+#define MULTI_GPU_H
+
+#include <complex>
+#include <memory>
+#include <vector>
+#include "../webgpu_utils.h"
+#include "../transform_options.h"
+
+// One WebGPUContext, with its own device, queue and caches, per adapter of a shared instance
+struct MultiGpuContext {
+    wgpu::Instance instance = nullptr;
+    std::vector<std::unique_ptr<WebGPUContext>> devices;
+};
+
+// Which enumerated adapters initMultiGpu opens
+enum class AdapterSelection {
+    Hardware, // discrete and integrated GPUs; software adapters only when there is no hardware one
+    All,      // also software rasterizers such as lavapipe, e.g. for testing on GPU-less machines
+};
+
+// Enumerates the adapters of the primary backends (Vulkan, Metal, DX12) and creates a device and
+// queue on each selected one; returns false when none could be opened
+bool initMultiGpu(MultiGpuContext& context, AdapterSelection selection = AdapterSelection::Hardware);
+
+void releaseMultiGpu(MultiGpuContext& context);
+
+// Work done by each device during one runMultiGpuBatch
+struct MultiGpuStats {
+    std::vector<int> transforms; // per device
+    std::vector<int> steals;     // per device: times it took work from another device's share
+    double seconds = 0.0;
+    double transformsPerSecond = 0.0;
+};
+
+// Transforms `batch` contiguous rows x cols complex64 matrices across every device, one host thread
+// each. Devices start with equal contiguous shares and claim them `chunk` matrices at a time into one
+// open-ended runStream per device, so slot buffers are allocated once and the pipeline never drains
+// between claims. A device whose share runs out steals the back half of the largest remaining share,
+// so faster devices end up doing more. The GPU work uses f32 storage.
+MultiGpuStats runMultiGpuBatch(
+    MultiGpuContext& context,
+    std::complex<float>* output,
+    const std::complex<float>* input,
+    int batch,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int chunk = 4,
+    int slots = 3
+);
+
+#endif // MULTI_GPU_H
@@ -0,0 +1,161 @@
+#include "bandwidth.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+static const int probeRepeats = 5;
+static const uint64_t probeBytes = 64ull << 20;
+static const uint32_t probeWorkgroupSize = 256;
+
+static wgpu::BindGroupLayout createProbeBindGroupLayout(wgpu::Device& device) {
+    wgpu::BindGroupLayoutEntry sourceLayout = {};
+    sourceLayout.binding = 0;
+    sourceLayout.visibility = wgpu::ShaderStage::Compute;
+    sourceLayout.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+
+    wgpu::BindGroupLayoutEntry destinationLayout = {};
+    destinationLayout.binding = 1;
+    destinationLayout.visibility = wgpu::ShaderStage::Compute;
+    destinationLayout.buffer.type = wgpu::BufferBindingType::Storage;
+
+    wgpu::BindGroupLayoutEntry entries[] = {sourceLayout, destinationLayout};
+
+    wgpu::BindGroupLayoutDescriptor layoutDesc = {};
+    layoutDesc.entryCount = 2;
+    layoutDesc.entries = entries;
+
+    return device.createBindGroupLayout(layoutDesc);
+}
+
+static wgpu::BindGroup createProbeBindGroup(wgpu::Device& device, wgpu::BindGroupLayout layout, wgpu::Buffer source, wgpu::Buffer destination, uint64_t bytes) {
+    wgpu::BindGroupEntry sourceEntry = {};
+    sourceEntry.binding = 0;
+    sourceEntry.buffer = source;
+    sourceEntry.size = bytes;
+
+    wgpu::BindGroupEntry destinationEntry = {};
+    destinationEntry.binding = 1;
+    destinationEntry.buffer = destination;
+    destinationEntry.size = bytes;
+
+    wgpu::BindGroupEntry entries[] = {sourceEntry, destinationEntry};
+
+    wgpu::BindGroupDescriptor bindGroupDesc = {};
+    bindGroupDesc.layout = layout;
+    bindGroupDesc.entryCount = 2;
+    bindGroupDesc.entries = entries;
+
+    return device.createBindGroup(bindGroupDesc);
+}
+
+const DeviceBandwidth& measureDeviceBandwidth(WebGPUContext& context) {
+    DeviceBandwidth& bandwidth = context.bandwidth;
+    if (bandwidth.measured) {
+        return bandwidth;
+    }
+
+    // Large enough to defeat caches, within the binding limit and one dispatch dimension
+    WGPUSupportedLimits limits = {};
+    wgpuDeviceGetLimits(context.device, &limits);
+    uint64_t bytes = std::min<uint64_t>(probeBytes, limits.limits.maxStorageBufferBindingSize);
+    bytes -= bytes % (16 * probeWorkgroupSize);
+    const uint32_t count = uint32_t(bytes / 16);
+    const uint32_t workgroups = count / probeWorkgroupSize;
+
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    wgpu::Buffer source = createBuffer(context, nullptr, bytes, usage);
+    wgpu::Buffer destination = createBuffer(context, nullptr, bytes, usage);
+    wgpu::BindGroupLayout layout = createProbeBindGroupLayout(context.device);
+    wgpu::BindGroup bindGroup = createProbeBindGroup(context.device, layout, source, destination, bytes);
+    wgpu::ComputePipeline pipeline = getComputePipeline(context, "src/profile/bandwidth_stream.wgsl", layout, {
+        {"WORKGROUP_SIZE", double(probeWorkgroupSize)},
+        {"COUNT", double(count)},
+    });
+
+    auto submitCopy = [&]() {
+        wgpu::CommandEncoder encoder = context.device.createCommandEncoder();
+        encodeBufferCopy(context, encoder, "probe copy", source, destination, bytes);
+        wgpu::CommandBuffer commandBuffer = encoder.finish();
+        submitCommandBuffer(context, commandBuffer);
+        commandBuffer.release();
+        encoder.release();
+    };
+    auto submitKernel = [&]() {
+        wgpu::CommandBuffer commandBuffer = createComputeCommandBuffer(context, {"probe kernel", 2.0 * bytes, 0.0}, pipeline, bindGroup, workgroups);
+        submitCommandBuffer(context, commandBuffer);
+        commandBuffer.release();
+    };
+
+    // One untimed run of each to page in the buffers and compile the pipeline
+    submitCopy();
+    submitKernel();
+    waitForQueueIdle(context.device, context.queue);
+
+    double bestCopyMs = 0.0;
+    double bestKernelMs = 0.0;
+    auto keepBest = [](double& best, double milliseconds) {
+        if (milliseconds > 0.0 && (best == 0.0 || milliseconds < best)) {
+            best = milliseconds;
+        }
+    };
+
+    if (!context.profiler.active && context.supportsTimestamps && beginProfiling(context, 2 * probeRepeats)) {
+        for (int repeat = 0; repeat < probeRepeats; ++repeat) {
+            submitCopy();
+            submitKernel();
+        }
+        for (const PassTiming& timing : endProfiling(context)) {
+            keepBest(timing.pass.label == "probe copy" ? bestCopyMs : bestKernelMs, timing.milliseconds);
+        }
+    } else {
+        for (int repeat = 0; repeat < probeRepeats; ++repeat) {
+            for (bool copy : {true, false}) {
+                const auto start = std::chrono::steady_clock::now();
+                copy ? submitCopy() : submitKernel();
+                waitForQueueIdle(context.device, context.queue);
+                const auto end = std::chrono::steady_clock::now();
+                keepBest(copy ? bestCopyMs : bestKernelMs, std::chrono::duration<double, std::milli>(end - start).count());
+            }
+        }
+    }
+
+    // Both probes read and write every byte once
+    bandwidth.copyGBs = bestCopyMs > 0.0 ? 2.0 * bytes / (bestCopyMs * 1e-3) * 1e-9 : 0.0;
+    bandwidth.kernelGBs = bestKernelMs > 0.0 ? 2.0 * bytes / (bestKernelMs * 1e-3) * 1e-9 : 0.0;
+    bandwidth.measured = true;
+
+    bindGroup.release();
+    layout.release();
+    releaseBuffer(context, source);
+    releaseBuffer(context, destination);
+    return bandwidth;
+}
+
+double peakBandwidthGBs(const DeviceBandwidth& bandwidth) {
+    return std::max(bandwidth.copyGBs, bandwidth.kernelGBs);
+}
+
+void printRoofline(const std::vector<PassTiming>& timings, const DeviceBandwidth& bandwidth) {
+    const double peak = peakBandwidthGBs(bandwidth);
+    double totalMs = 0.0;
+    for (const PassTiming& timing : timings) {
+        totalMs += timing.milliseconds;
+    }
+    std::cout << "peak_gb_per_s " << peak << " (copy " << bandwidth.copyGBs << ", kernel " << bandwidth.kernelGBs << ")\n";
+    std::cout << std::left << std::setw(28) << "pass" << std::right
+              << std::setw(12) << "ms" << std::setw(10) << "% time" << std::setw(12) << "MB" << std::setw(12) << "GB/s"
+              << std::setw(12) << "GFLOP/s" << std::setw(12) << "% peak" << "\n";
+    for (const PassTiming& timing : timings) {
+        const double seconds = timing.milliseconds * 1e-3;
+        const double gbPerSecond = seconds > 0.0 ? timing.pass.bytes / seconds * 1e-9 : 0.0;
+        const double gflops = seconds > 0.0 ? timing.pass.flops / seconds * 1e-9 : 0.0;
+        std::cout << std::left << std::setw(28) << timing.pass.label << std::right
+                  << std::setw(12) << timing.milliseconds
+                  << std::setw(10) << (totalMs > 0.0 ? 100.0 * timing.milliseconds / totalMs : 0.0)
+                  << std::setw(12) << timing.pass.bytes * 1e-6
+                  << std::setw(12) << gbPerSecond
+                  << std::setw(12) << gflops
+                  << std::setw(12) << (peak > 0.0 ? 100.0 * gbPerSecond / peak : 0.0) << "\n";
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef BANDWIDTH_H
+#define BANDWIDTH_H
+
+#include <vector>
+#include "../webgpu_utils.h"
+
+// Measures the device's achievable global-memory bandwidth with a buffer copy and a streaming
+// read/write kernel, best of several runs. The result is cached on the context, so the probe
+// runs once per device. Uses timestamp queries when available (and no profile is in progress),
+// otherwise wall-clock time around each submission.
+const DeviceBandwidth& measureDeviceBandwidth(WebGPUContext& context);
+
+// Peak bandwidth used as the roofline reference: the faster of the two probes
+double peakBandwidthGBs(const DeviceBandwidth& bandwidth);
+
+// Prints each profiled pass with its GPU time and share of the total, modeled bytes and flops, achieved GB/s and GFLOP/s,
+// and the fraction of the probed peak bandwidth it reaches
+void printRoofline(const std::vector<PassTiming>& timings, const DeviceBandwidth& bandwidth);
+
+#endif // BANDWIDTH_H
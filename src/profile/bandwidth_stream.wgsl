@@ -0,0 +1,15 @@
+// Streaming read/write kernel for the device bandwidth probe: every invocation copies one vec4
+@group(0) @binding(0) var<storage, read> source: array<vec4<f32>>;
+@group(0) @binding(1) var<storage, read_write> destination: array<vec4<f32>>;
+
+override WORKGROUP_SIZE: u32 = 256u;
+override COUNT: u32;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
+    let index = global_id.x;
+    if (index >= COUNT) {
+        return;
+    }
+    destination[index] = source[index];
+}
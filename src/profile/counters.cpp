@@ -0,0 +1,19 @@
+#include "counters.h"
+
+void printCounters(std::ostream& out, const RuntimeCounters& counters) {
+    out << "counters\n";
+    out << "buffers_created " << counters.buffersCreated << "\n";
+    out << "bytes_allocated " << counters.bytesAllocated << "\n";
+    out << "buffers_live " << counters.buffersLive << "\n";
+    out << "bytes_live " << counters.bytesLive << "\n";
+    out << "shader_compiles " << counters.shaderCompiles << "\n";
+    out << "shader_cache_hits " << counters.shaderCacheHits << "\n";
+    out << "pipeline_compiles " << counters.pipelineCompiles << "\n";
+    out << "pipeline_cache_hits " << counters.pipelineCacheHits << "\n";
+    out << "dispatches " << counters.dispatches << "\n";
+    out << "submits " << counters.submits << "\n";
+    out << "uploads " << counters.uploads << "\n";
+    out << "bytes_uploaded " << counters.bytesUploaded << "\n";
+    out << "readbacks " << counters.readBacks << "\n";
+    out << "bytes_downloaded " << counters.bytesDownloaded << "\n";
+}
@@ -0,0 +1,11 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <ostream>
+#include "../webgpu_utils.h"
+
+// Prints every counter as a `name value` line under a `counters` heading, matching the CLI's
+// benchmark and profile output
+void printCounters(std::ostream& out, const RuntimeCounters& counters);
+
+#endif // COUNTERS_H
@@ -0,0 +1,116 @@
+#include "trace.h"
+
+#ifdef WGPU_DFT_TRACING
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+
+namespace {
+
+const int gpuTrack = 2;
+
+struct TraceEvent {
+    std::string name;
+    int track; // gpuTrack, or the recording host thread's id
+    double startUs;
+    double durationUs;
+};
+
+struct TraceState {
+    std::mutex mutex;
+    bool recording = false;
+    std::chrono::steady_clock::time_point origin;
+    std::vector<TraceEvent> events;
+};
+
+TraceState& traceState() {
+    static TraceState state;
+    return state;
+}
+
+// Host threads get tids 1, 3, 4, ... in the order they first record a span, leaving 2 to the GPU
+int hostTrack() {
+    static std::atomic<int> threadCount{0};
+    thread_local const int track = [] {
+        const int index = threadCount++;
+        return index == 0 ? 1 : index + gpuTrack;
+    }();
+    return track;
+}
+
+double microsecondsSince(std::chrono::steady_clock::time_point origin, std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration<double, std::micro>(time - origin).count();
+}
+
+} // namespace
+
+TraceScope::TraceScope(const char* name) : name(name), start(std::chrono::steady_clock::now()) {}
+
+TraceScope::~TraceScope() {
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    const int track = hostTrack();
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.recording) {
+        state.events.push_back({name, track, microsecondsSince(state.origin, start), microsecondsSince(start, end)});
+    }
+}
+
+void traceStart() {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.events.clear();
+    state.origin = std::chrono::steady_clock::now();
+    state.recording = true;
+}
+
+void traceGpuPasses(const std::vector<PassTiming>& timings, std::chrono::steady_clock::time_point firstPassHost) {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.recording) {
+        return;
+    }
+    // GPU ticks share no clock with the host; the first pass cannot start before it was submitted
+    const double anchorUs = microsecondsSince(state.origin, firstPassHost);
+    for (const PassTiming& timing : timings) {
+        state.events.push_back({timing.pass.label, gpuTrack, anchorUs + 1e3 * timing.startMs, 1e3 * timing.milliseconds});
+    }
+}
+
+bool traceWrite(const std::string& path) {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.recording = false;
+
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open trace file " << path << std::endl;
+        return false;
+    }
+    std::set<int> hostTracks = {1};
+    for (const TraceEvent& event : state.events) {
+        if (event.track != gpuTrack) {
+            hostTracks.insert(event.track);
+        }
+    }
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << gpuTrack << ",\"args\":{\"name\":\"GPU\"}}";
+    for (int track : hostTracks) {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track << ",\"args\":{\"name\":\"host";
+        if (track != 1) {
+            file << " " << track;
+        }
+        file << "\"}}";
+    }
+    for (const TraceEvent& event : state.events) {
+        file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.track
+             << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+    }
+    file << "\n]}\n";
+    return bool(file);
+}
+
+#endif // WGPU_DFT_TRACING
@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../webgpu_utils.h"
+
+// Chrome trace-event recorder (load the output in chrome://tracing or ui.perfetto.dev).
+// Host spans are recorded with TRACE_SCOPE; GPU passes come from the timestamp profiler and
+// are placed on their own track. Built only with -DWGPU_DFT_TRACING=ON: otherwise the macro
+// expands to nothing and the functions below are empty inline stubs.
+
+#ifdef WGPU_DFT_TRACING
+
+// Records a complete ("X") event covering the enclosing scope while tracing is started
+class TraceScope {
+public:
+    explicit TraceScope(const char* name);
+    ~TraceScope();
+
+private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+// Clears previous events and starts recording
+void traceStart();
+
+// Adds GPU pass durations; `firstPassHost` anchors the first pass on the host timeline
+void traceGpuPasses(const std::vector<PassTiming>& timings, std::chrono::steady_clock::time_point firstPassHost);
+
+// Stops recording and writes the events as Chrome trace JSON; returns false on I/O failure
+bool traceWrite(const std::string& path);
+
+#else
+
+#define TRACE_SCOPE(name) static_cast<void>(0)
+
+inline void traceStart() {}
+inline void traceGpuPasses(const std::vector<PassTiming>&, std::chrono::steady_clock::time_point) {}
+inline bool traceWrite(const std::string&) { return false; }
+
+#endif // WGPU_DFT_TRACING
+
+// Whether this build records traces
+inline bool traceAvailable() {
+#ifdef WGPU_DFT_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+#endif // TRACE_H
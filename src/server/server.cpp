@@ -0,0 +1,268 @@
+#include "server.h"
+#include "../cache/result_cache.h"
+#include "../fft/fft.h"
+#include "../profile/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <sstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+// Device memory the per-shape buffers of recent jobs may hold; the current job's shape is always kept
+static const uint64_t shapeBufferBudget = uint64_t(256) << 20;
+
+// Device buffers kept per shape, so repeated jobs allocate nothing
+struct ShapeBuffers {
+    int rows = 0;
+    int cols = 0;
+    uint64_t bytes = 0; // both buffers together
+    wgpu::Buffer input = nullptr;
+    wgpu::Buffer output = nullptr;
+};
+
+struct ServerState {
+    WebGPUContext& context;
+    TransformOptions options;
+    std::list<ShapeBuffers> buffers; // most recently used first
+    uint64_t bufferBytes = 0;
+    ResultCache cache;
+    bool stopping = false;
+};
+
+static void releaseShapeBuffers(ServerState& state, ShapeBuffers& buffers) {
+    releaseBuffer(state.context, buffers.input);
+    releaseBuffer(state.context, buffers.output);
+    state.bufferBytes -= buffers.bytes;
+}
+
+// Returns the buffers for a shape, moved to the front of the list. A new shape first releases the
+// least recently used shapes until it fits in shapeBufferBudget.
+static ShapeBuffers& buffersForShape(ServerState& state, int rows, int cols) {
+    for (auto entry = state.buffers.begin(); entry != state.buffers.end(); ++entry) {
+        if (entry->rows == rows && entry->cols == cols) {
+            state.buffers.splice(state.buffers.begin(), state.buffers, entry);
+            return state.buffers.front();
+        }
+    }
+
+    const size_t bytes = complexElementSize(StorageFormat::Float32) * size_t(rows) * size_t(cols);
+    while (!state.buffers.empty() && state.bufferBytes + 2 * bytes > shapeBufferBudget) {
+        releaseShapeBuffers(state, state.buffers.back());
+        state.buffers.pop_back();
+    }
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    ShapeBuffers buffers;
+    buffers.rows = rows;
+    buffers.cols = cols;
+    buffers.bytes = 2 * bytes;
+    buffers.input = createBuffer(state.context, nullptr, bytes, usage);
+    buffers.output = createBuffer(state.context, nullptr, bytes, usage);
+    state.bufferBytes += buffers.bytes;
+    state.buffers.push_front(buffers);
+    return state.buffers.front();
+}
+
+// Maps the job's shared file, transforms it in place and returns the reply line
+static std::string runJob(ServerState& state, const std::string& path, int rows, int cols, uint32_t doInverse) {
+    TRACE_SCOPE("server job");
+    const size_t total = size_t(rows) * size_t(cols);
+    const size_t bytes = complexElementSize(StorageFormat::Float32) * total;
+
+    const int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return std::string("error cannot open ") + path + ": " + std::strerror(errno);
+    }
+    struct stat status = {};
+    if (fstat(fd, &status) != 0 || size_t(status.st_size) < bytes) {
+        close(fd);
+        return "error " + path + " is smaller than " + std::to_string(bytes) + " bytes";
+    }
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return std::string("error cannot map ") + path + ": " + std::strerror(errno);
+    }
+
+    std::string reply;
+    try {
+        const auto start = std::chrono::steady_clock::now();
+        ShapeBuffers& buffers = buffersForShape(state, rows, cols);
+        std::string outcome;
+        if (state.cache.budgetBytes > 0) {
+            outcome = fftCached(state.context, state.cache, buffers.output, mapping, rows, cols, doInverse, state.options) ? " hit" : " miss";
+        } else {
+            writeBuffer(state.context, buffers.input, 0, mapping, bytes);
+            fft(state.context, buffers.output, buffers.input, total, rows, cols, doInverse, state.options);
+        }
+        if (readBackInto(state.context, buffers.output, static_cast<float*>(mapping), 2 * total)) {
+            const auto end = std::chrono::steady_clock::now();
+            reply = "ok " + std::to_string(std::chrono::duration<double, std::milli>(end - start).count()) + outcome;
+        } else {
+            reply = "error readback failed";
+        }
+    } catch (const std::exception& error) {
+        reply = std::string("error ") + error.what();
+    }
+    munmap(mapping, bytes);
+    return reply;
+}
+
+static std::string handleRequest(ServerState& state, const std::string& line) {
+    std::istringstream request(line);
+    std::string command;
+    request >> command;
+    if (command == "ping") {
+        return "ok";
+    }
+    if (command == "stats") {
+        const ResultCacheStats& stats = state.cache.stats;
+        return "ok hits " + std::to_string(stats.hits) + " misses " + std::to_string(stats.misses)
+            + " evictions " + std::to_string(stats.evictions) + " bytes " + std::to_string(state.cache.bytes);
+    }
+    if (command == "shutdown") {
+        state.stopping = true;
+        return "ok";
+    }
+    if (command == "fft") {
+        std::string path;
+        std::string direction;
+        int rows = 0;
+        int cols = 0;
+        if (!(request >> path >> rows >> cols >> direction) || rows <= 0 || cols <= 0
+            || (direction != "forward" && direction != "backward")) {
+            return "error usage: fft <path> <rows> <cols> <forward|backward>";
+        }
+        // A buffer over the device limits is a validation error, which would abort the whole server
+        const uint64_t bytes = complexElementSize(StorageFormat::Float32) * uint64_t(rows) * uint64_t(cols);
+        WGPUSupportedLimits limits = {};
+        if (!wgpuDeviceGetLimits(state.context.device, &limits)) {
+            return "error cannot query the device limits";
+        }
+        const uint64_t limit = std::min(limits.limits.maxBufferSize, limits.limits.maxStorageBufferBindingSize);
+        if (bytes > limit) {
+            return "error " + std::to_string(rows) + "x" + std::to_string(cols) + " needs " + std::to_string(bytes)
+                + " bytes per buffer, over the device limit of " + std::to_string(limit);
+        }
+        return runJob(state, path, rows, cols, direction == "backward" ? 1 : 0);
+    }
+    return "error unknown command '" + command + "'";
+}
+
+static bool sendLine(int client, const std::string& line) {
+    const std::string message = line + "\n";
+    size_t sent = 0;
+    while (sent < message.size()) {
+        const ssize_t count = send(client, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        sent += size_t(count);
+    }
+    return true;
+}
+
+// Answers one client's requests until it disconnects or asks the server to stop
+static void serveClient(ServerState& state, int client) {
+    std::string pending;
+    char chunk[4096];
+    while (!state.stopping) {
+        const ssize_t count = recv(client, chunk, sizeof(chunk), 0);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return;
+        }
+        pending.append(chunk, size_t(count));
+        size_t newline;
+        while (!state.stopping && (newline = pending.find('\n')) != std::string::npos) {
+            const std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (!sendLine(client, handleRequest(state, line))) {
+                return;
+            }
+        }
+    }
+}
+
+bool runServer(WebGPUContext& context, const std::string& socketPath, const TransformOptions& options, uint64_t cacheBytes) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path is too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    // A socket file left behind by a previous server would make bind fail, but any other file at the
+    // path belongs to someone else and is left alone
+    struct stat existing;
+    if (lstat(socketPath.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << "Cannot listen on " << socketPath << ": path exists and is not a socket" << std::endl;
+            return false;
+        }
+        unlink(socketPath.c_str());
+    }
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        std::cerr << "Failed to listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+    std::cout << "listening " << socketPath << std::endl;
+
+    ServerState state = {context, options, {}, 0, {}, false};
+    state.options.storage = StorageFormat::Float32;
+    state.cache.budgetBytes = cacheBytes;
+    while (!state.stopping) {
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Failed to accept a client: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        serveClient(state, client);
+        close(client);
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+    clearResultCache(context, state.cache);
+    for (ShapeBuffers& buffers : state.buffers) {
+        releaseShapeBuffers(state, buffers);
+    }
+    return state.stopping;
+}
+
+#else
+
+bool runServer(WebGPUContext&, const std::string&, const TransformOptions&, uint64_t) {
+    std::cerr << "Server mode needs Unix domain sockets, which this platform build does not support" << std::endl;
+    return false;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstdint>
+#include <string>
+#include "../webgpu_utils.h"
+#include "../transform_options.h"
+
+// Serves transform jobs on a Unix domain socket until a client sends `shutdown`, keeping the device,
+// pipelines and the device buffers of recent shapes (up to 256 MiB) warm between jobs. Each request is one text line:
+//
+//   fft <path> <rows> <cols> <forward|backward>   transform the matrix in a shared file in place
+//   ping                                           liveness check
+//   stats                                          result-cache hits, misses and evictions
+//   shutdown                                       reply, then stop serving
+//
+// and is answered with `ok [milliseconds]` or `error <reason>`. With a result cache of `cacheBytes`,
+// fft replies end in `hit` or `miss`, and repeated inputs are answered from device-resident results. The shared file (typically under
+// /dev/shm) holds rows * cols row-major complex64 values and no header; the server maps it, uploads
+// it, and writes the result back into it before replying. Every job uses `options` with f32 storage.
+// Clients are served one at a time, each for as many requests as it sends. Returns false if the
+// socket cannot be set up, or on platforms without Unix domain sockets.
+bool runServer(WebGPUContext& context, const std::string& socketPath, const TransformOptions& options, uint64_t cacheBytes = 0);
+
+#endif // SERVER_H
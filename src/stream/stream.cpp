@@ -0,0 +1,128 @@
+#include "stream.h"
+#include "../fft/fft.h"
+#include <algorithm>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Device buffers and host landing area for one in-flight frame
+struct FrameSlot {
+    wgpu::Buffer input = nullptr;
+    wgpu::Buffer output = nullptr;
+    std::vector<unsigned char> result;
+    AsyncJob compute;
+    AsyncJob download;
+    Clock::time_point submitted;
+    int frame = -1;
+};
+
+// Busy time per stage, accumulated as frames retire in order
+struct StageClock {
+    double uploadSeconds = 0.0;
+    double computeSeconds = 0.0;
+    double downloadSeconds = 0.0;
+    Clock::time_point lastComputeDone;
+    Clock::time_point lastDownloadDone;
+};
+
+static double secondsBetween(Clock::time_point start, Clock::time_point end) {
+    return end > start ? std::chrono::duration<double>(end - start).count() : 0.0;
+}
+
+// Waits for a slot's readback, accounts its stage times and hands the result to the sink
+static void retireFrame(WebGPUContext& context, FrameSlot& slot, StageClock& clock, const FrameSink& sink) {
+    waitForJob(context, slot.compute);
+    waitForJob(context, slot.download);
+
+    // The GPU runs one submission at a time, so a stage starts once both its input and the
+    // previous frame's use of the stage are done
+    const Clock::time_point computeStart = std::max(slot.submitted, clock.lastComputeDone);
+    clock.computeSeconds += secondsBetween(computeStart, slot.compute->completedAt);
+    clock.lastComputeDone = slot.compute->completedAt;
+
+    const Clock::time_point downloadStart = std::max(slot.compute->completedAt, clock.lastDownloadDone);
+    clock.downloadSeconds += secondsBetween(downloadStart, slot.download->completedAt);
+    clock.lastDownloadDone = slot.download->completedAt;
+
+    sink(slot.frame, slot.result.data(), slot.result.size());
+    slot.frame = -1;
+}
+
+StreamStats runStream(
+    WebGPUContext& context,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int frames,
+    int slots,
+    const FrameSource& source,
+    const FrameSink& sink
+) {
+    StreamStats stats;
+    slots = std::max(slots, 1);
+    const size_t total = size_t(rows) * size_t(cols);
+    const size_t bytes = complexElementSize(options.storage) * total;
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+
+    // One staging buffer per slot, so every slot's readback can be mapping at once
+    reserveStagingSlots(context, size_t(slots));
+    std::vector<FrameSlot> frameSlots(slots);
+    for (FrameSlot& slot : frameSlots) {
+        slot.input = createBuffer(context, nullptr, bytes, usage);
+        slot.output = createBuffer(context, nullptr, bytes, usage);
+        slot.result.resize(bytes);
+    }
+
+    StageClock clock;
+    const Clock::time_point start = Clock::now();
+    clock.lastComputeDone = start;
+    clock.lastDownloadDone = start;
+
+    int submitted = 0;
+    for (; frames < 0 || submitted < frames; ++submitted) {
+        FrameSlot& slot = frameSlots[submitted % slots];
+        if (slot.frame >= 0) {
+            retireFrame(context, slot, clock, sink);
+        }
+
+        const Clock::time_point uploadStart = Clock::now();
+        const void* frameData = source(submitted);
+        if (!frameData) {
+            break;
+        }
+        writeBuffer(context, slot.input, 0, frameData, bytes);
+        slot.submitted = Clock::now();
+        clock.uploadSeconds += secondsBetween(uploadStart, slot.submitted);
+
+        slot.compute = fftAsync(context, slot.output, slot.input, total, rows, cols, doInverse, options);
+        slot.download = readBackAsync(context, slot.output, slot.result.data(), bytes);
+        slot.frame = submitted;
+
+        // Fire callbacks for anything already finished so completion times stay accurate
+        pollAsync(context);
+    }
+
+    // Drain the remaining slots, oldest frame first
+    for (int frame = std::max(submitted - slots, 0); frame < submitted; ++frame) {
+        FrameSlot& slot = frameSlots[frame % slots];
+        if (slot.frame >= 0) {
+            retireFrame(context, slot, clock, sink);
+        }
+    }
+
+    stats.frames = submitted;
+    stats.seconds = secondsBetween(start, Clock::now());
+    if (stats.seconds > 0.0) {
+        stats.framesPerSecond = submitted / stats.seconds;
+        stats.uploadOccupancy = clock.uploadSeconds / stats.seconds;
+        stats.computeOccupancy = clock.computeSeconds / stats.seconds;
+        stats.downloadOccupancy = clock.downloadSeconds / stats.seconds;
+    }
+
+    for (FrameSlot& slot : frameSlots) {
+        releaseBuffer(context, slot.input);
+        releaseBuffer(context, slot.output);
+    }
+    return stats;
+}
@@ -0,0 +1,43 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <webgpu/webgpu.hpp>
+#include <functional>
+#include "../webgpu_utils.h"
+#include "../transform_options.h"
+
+// Sustained throughput of a streaming run. Occupancy is the fraction of wall time a stage was
+// busy: upload is host time spent queueing frame data, compute and download span from when a
+// stage could start to when its completion callback was observed.
+struct StreamStats {
+    int frames = 0;
+    double seconds = 0.0;
+    double framesPerSecond = 0.0;
+    double uploadOccupancy = 0.0;
+    double computeOccupancy = 0.0;
+    double downloadOccupancy = 0.0;
+};
+
+// Supplies a frame's input: rows * cols complex elements in the transform's storage format, or
+// nullptr to end an open-ended stream
+using FrameSource = std::function<const void*(int frame)>;
+
+// Receives a frame's result in the storage format; `data` is only valid during the call
+using FrameSink = std::function<void(int frame, const void* data, size_t bytes)>;
+
+// Transforms `frames` frames through `slots` in-flight frame slots, so frame k+1 uploads while
+// frame k computes and frame k-1 maps back. Frames reach the sink in order. With `frames` < 0 the
+// stream runs until `source` returns nullptr, so work arriving piecemeal shares one set of slots.
+StreamStats runStream(
+    WebGPUContext& context,
+    int rows,
+    int cols,
+    uint32_t doInverse,
+    const TransformOptions& options,
+    int frames,
+    int slots,
+    const FrameSource& source,
+    const FrameSink& sink
+);
+
+#endif // STREAM_H
@@ -0,0 +1,86 @@
+#ifndef TRANSFORM_OPTIONS_H
+#define TRANSFORM_OPTIONS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Scaling conventions, named after numpy.fft's `norm` argument
+enum class Normalization {
+    Backward, // forward unscaled, inverse scaled by 1/N
+    Ortho,    // both directions scaled by 1/sqrt(N)
+    Forward,  // forward scaled by 1/N, inverse unscaled
+    None,     // neither direction scaled
+};
+
+// Element format of complex data in global memory; arithmetic is always f32
+enum class StorageFormat {
+    Float32, // vec2<f32>, 8 bytes per element
+    Float16, // vec2<f16>, 4 bytes per element, requires the shader-f16 feature
+};
+
+// Accumulation strategy of the direct DFT kernels
+enum class DftPrecision {
+    Standard,    // plain f32 accumulation, float phase reduction
+    Compensated, // exact integer phase reduction and Kahan summation, for large non-power-of-2 sizes
+};
+
+// Options shared by the FFT and DFT engines
+struct TransformOptions {
+    bool forceDft = false;
+    Normalization normalization = Normalization::Backward;
+    StorageFormat storage = StorageFormat::Float32;
+    DftPrecision dftPrecision = DftPrecision::Standard;
+    // Workgroup shape of every pass; 0 uses sqrt(maxInvocationsPerWorkgroup) in both dimensions
+    uint32_t workgroupX = 0;
+    uint32_t workgroupY = 0;
+    // Let fft() replace the engine and workgroup shape with a tuned plan for this shape, if one is loaded
+    bool useWisdom = true;
+};
+
+// Bytes per complex element in a buffer of the given format
+inline size_t complexElementSize(StorageFormat storage) {
+    return storage == StorageFormat::Float16 ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+}
+
+// WGSL prepended to every kernel to select the `storage_t` element type
+inline const char* storagePrelude(StorageFormat storage) {
+    if (storage == StorageFormat::Float16) {
+        return "enable f16;\nalias storage_t = vec2<f16>;\n";
+    }
+    return "alias storage_t = vec2<f32>;\n";
+}
+
+// Scale applied once to the final result of a rows x cols transform
+inline double normalizationScale(Normalization normalization, bool inverse, int rows, int cols) {
+    const double n = double(rows) * double(cols);
+    switch (normalization) {
+        case Normalization::Backward:
+            return inverse ? 1.0 / n : 1.0;
+        case Normalization::Ortho:
+            return 1.0 / std::sqrt(n);
+        case Normalization::Forward:
+            return inverse ? 1.0 : 1.0 / n;
+        case Normalization::None:
+            break;
+    }
+    return 1.0;
+}
+
+// Supplies rows [firstRow, firstRow + rowCount) of a row-streamed input in the storage format
+using RowBlockSource = std::function<const void*(int firstRow, int rowCount)>;
+
+// Rounds a requested row-block height up so every block starts on a storage-buffer offset
+// alignment boundary; the result is at least one row and at most `rows`
+inline int alignBlockRows(int requested, int rows, uint64_t rowBytes, uint64_t offsetAlignment) {
+    uint64_t step = 1;
+    while ((step * rowBytes) % offsetAlignment != 0) {
+        ++step;
+    }
+    const uint64_t wanted = uint64_t(requested > 0 ? requested : 1);
+    const uint64_t aligned = (wanted + step - 1) / step * step;
+    return int(aligned < uint64_t(rows) ? aligned : uint64_t(rows));
+}
+
+#endif // TRANSFORM_OPTIONS_H
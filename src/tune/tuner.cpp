@@ -0,0 +1,150 @@
+#include "tuner.h"
+#include "../fft/fft.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Workgroup shapes tried per engine; shapes beyond the device limits are clamped and deduplicated
+static const uint32_t candidateShapes[][2] = {
+    {0, 0}, {8, 8}, {16, 16}, {32, 8}, {8, 32}, {64, 4}, {32, 32}, {256, 1},
+};
+
+static const char* storageName(StorageFormat storage) {
+    return storage == StorageFormat::Float16 ? "f16" : "f32";
+}
+
+static const char* precisionName(DftPrecision precision) {
+    return precision == DftPrecision::Compensated ? "compensated" : "standard";
+}
+
+// Tab-separated, as adapter names contain spaces; a wisdom line appends engine, workgroup shape and time
+std::string wisdomKey(const WebGPUContext& context, int rows, int cols, const TransformOptions& options) {
+    std::ostringstream key;
+    key << context.adapterName << "\t" << rows << "\t" << cols << "\t" << storageName(options.storage) << "\t" << precisionName(options.dftPrecision);
+    return key.str();
+}
+
+const TunedPlan* findWisdom(const WebGPUContext& context, int rows, int cols, const TransformOptions& options) {
+    auto plan = context.wisdom.find(wisdomKey(context, rows, cols, options));
+    return plan != context.wisdom.end() ? &plan->second : nullptr;
+}
+
+// Median wall-clock time of `repeats` synchronous transforms after one warm-up run
+static double timeCandidate(
+    WebGPUContext& context,
+    wgpu::Buffer& outputBuffer,
+    wgpu::Buffer& inputBuffer,
+    int rows,
+    int cols,
+    const TransformOptions& options,
+    int repeats
+) {
+    const size_t total = size_t(rows) * size_t(cols);
+    fft(context, outputBuffer, inputBuffer, total, rows, cols, 0, options);
+    waitForQueueIdle(context.device, context.queue);
+
+    std::vector<double> durationsMs;
+    for (int iteration = 0; iteration < repeats; ++iteration) {
+        const auto start = std::chrono::steady_clock::now();
+        fft(context, outputBuffer, inputBuffer, total, rows, cols, 0, options);
+        waitForQueueIdle(context.device, context.queue);
+        durationsMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(durationsMs.begin(), durationsMs.end());
+    return durationsMs[durationsMs.size() / 2];
+}
+
+std::vector<TunedPlan> tuneTransform(WebGPUContext& context, int rows, int cols, const TransformOptions& options, int repeats) {
+    repeats = std::max(repeats, 1);
+    const size_t bytes = complexElementSize(options.storage) * size_t(rows) * size_t(cols);
+    const WGPUBufferUsage usage = WGPUBufferUsage(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    // Run time does not depend on the values, so zero-initialized input is enough
+    wgpu::Buffer inputBuffer = createBuffer(context, nullptr, bytes, usage);
+    wgpu::Buffer outputBuffer = createBuffer(context, nullptr, bytes, usage);
+
+    std::vector<bool> engines = {true};
+    if (isValidFFTDimensions(rows, cols)) {
+        engines.push_back(false);
+    }
+
+    std::vector<TunedPlan> results;
+    for (bool useDft : engines) {
+        std::vector<std::pair<uint32_t, uint32_t>> tried;
+        for (const auto& candidate : candidateShapes) {
+            const WorkgroupLimits shape = getWorkgroupShape(context.device, candidate[0], candidate[1]);
+            const std::pair<uint32_t, uint32_t> resolved = {uint32_t(shape.maxWorkgroupSizeX), uint32_t(shape.maxWorkgroupSizeY)};
+            if (std::find(tried.begin(), tried.end(), resolved) != tried.end()) {
+                continue;
+            }
+            tried.push_back(resolved);
+
+            TransformOptions candidateOptions = options;
+            candidateOptions.forceDft = useDft;
+            candidateOptions.workgroupX = resolved.first;
+            candidateOptions.workgroupY = resolved.second;
+            candidateOptions.useWisdom = false;
+
+            TunedPlan plan;
+            plan.useDft = useDft;
+            plan.workgroupX = resolved.first;
+            plan.workgroupY = resolved.second;
+            plan.milliseconds = timeCandidate(context, outputBuffer, inputBuffer, rows, cols, candidateOptions, repeats);
+            results.push_back(plan);
+        }
+    }
+
+    releaseBuffer(context, inputBuffer);
+    releaseBuffer(context, outputBuffer);
+
+    std::stable_sort(results.begin(), results.end(), [](const TunedPlan& a, const TunedPlan& b) {
+        return a.milliseconds < b.milliseconds;
+    });
+    context.wisdom[wisdomKey(context, rows, cols, options)] = results.front();
+    return results;
+}
+
+bool loadWisdom(WebGPUContext& context, const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 9) {
+            continue;
+        }
+        try {
+            TunedPlan plan;
+            plan.useDft = fields[5] == "dft";
+            plan.workgroupX = uint32_t(std::stoul(fields[6]));
+            plan.workgroupY = uint32_t(std::stoul(fields[7]));
+            plan.milliseconds = std::stod(fields[8]);
+            context.wisdom[fields[0] + "\t" + fields[1] + "\t" + fields[2] + "\t" + fields[3] + "\t" + fields[4]] = plan;
+        } catch (const std::exception&) {
+            std::cerr << "Skipping malformed wisdom line: " << line << std::endl;
+        }
+    }
+    return true;
+}
+
+bool saveWisdom(const WebGPUContext& context, const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open wisdom file " << path << std::endl;
+        return false;
+    }
+    for (const auto& entry : context.wisdom) {
+        const TunedPlan& plan = entry.second;
+        file << entry.first << "\t" << (plan.useDft ? "dft" : "fft") << "\t" << plan.workgroupX << "\t"
+             << plan.workgroupY << "\t" << plan.milliseconds << "\n";
+    }
+    return bool(file);
+}
@@ -0,0 +1,27 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <string>
+#include <vector>
+#include "../webgpu_utils.h"
+#include "../transform_options.h"
+
+// Key of a tuned plan: adapter, shape, storage format and DFT precision. Direction and
+// normalization only change override constants, so one plan serves both directions.
+std::string wisdomKey(const WebGPUContext& context, int rows, int cols, const TransformOptions& options);
+
+// Tuned plan for this shape on the context's adapter, or nullptr when it has not been tuned
+const TunedPlan* findWisdom(const WebGPUContext& context, int rows, int cols, const TransformOptions& options);
+
+// Times every candidate engine (the FFT only for power-of-2 shapes) and workgroup shape within the
+// device limits, `repeats` runs each after a warm-up, and records the fastest in context.wisdom.
+// Returns the candidates fastest first.
+std::vector<TunedPlan> tuneTransform(WebGPUContext& context, int rows, int cols, const TransformOptions& options, int repeats = 10);
+
+// Merges the plans in a wisdom file into context.wisdom; returns false if the file cannot be read
+bool loadWisdom(WebGPUContext& context, const std::string& path);
+
+// Writes every plan in context.wisdom, one tab-separated line each; returns false on I/O failure
+bool saveWisdom(const WebGPUContext& context, const std::string& path);
+
+#endif // TUNER_H
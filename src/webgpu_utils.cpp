@@ -1,12 +1,16 @@
 #include "webgpu_utils.h"
+#include "profile/trace.h"
+#include <algorithm>
+#include <cmath>
 
 // INITIALIZING WEBGPU
-void initWebGPU(WebGPUContext& context) {
+bool initWebGPU(WebGPUContext& context) {
     // Create an instance
     wgpu::InstanceDescriptor instanceDescriptor = {};
     context.instance = wgpu::createInstance(instanceDescriptor);
     if (!context.instance) {
         std::cerr << "Failed to create WebGPU instance." << std::endl;
+        return false;
     }
 
     // Request adapter
@@ -15,16 +19,37 @@ void initWebGPU(WebGPUContext& context) {
     context.adapter = context.instance.requestAdapter(adapterOptions);
     if (!context.adapter) {
         std::cerr << "Failed to request a WebGPU adapter." << std::endl;
+        return false;
     }
+    return initWebGPUDevice(context);
+}
 
+bool initWebGPUDevice(WebGPUContext& context) {
     // Get adapter's limits
     WGPUSupportedLimits supportedLimits = {};
     wgpuAdapterGetLimits(context.adapter, &supportedLimits);
 
+    // The adapter name keys tuning results, which only transfer between identical devices
+    WGPUAdapterProperties properties = {};
+    wgpuAdapterGetProperties(context.adapter, &properties);
+    context.adapterName = properties.name ? properties.name : "unknown";
+
     // Request device
     wgpu::DeviceDescriptor deviceDescriptor = {};
     deviceDescriptor.label = "Default Device";
 
+    // Enable half-precision storage when the adapter supports it
+    std::vector<wgpu::FeatureName> requiredFeatures;
+    if (context.adapter.hasFeature(wgpu::FeatureName::ShaderF16)) {
+        requiredFeatures.push_back(wgpu::FeatureName::ShaderF16);
+    }
+    // Timestamp queries back the optional per-pass profiler
+    if (context.adapter.hasFeature(wgpu::FeatureName::TimestampQuery)) {
+        requiredFeatures.push_back(wgpu::FeatureName::TimestampQuery);
+    }
+    deviceDescriptor.requiredFeatureCount = requiredFeatures.size();
+    deviceDescriptor.requiredFeatures = reinterpret_cast<const WGPUFeatureName*>(requiredFeatures.data());
+
     // Align device limits to that of adapter
     WGPURequiredLimits requiredLimits = {};
     requiredLimits.limits = supportedLimits.limits;
@@ -33,13 +58,63 @@ void initWebGPU(WebGPUContext& context) {
     context.device = context.adapter.requestDevice(deviceDescriptor);
     if (!context.device) {
         std::cerr << "Failed to request a WebGPU device." << std::endl;
+        return false;
     }
+    context.supportsF16 = context.device.hasFeature(wgpu::FeatureName::ShaderF16);
+    context.supportsTimestamps = context.device.hasFeature(wgpu::FeatureName::TimestampQuery);
 
     // Retrieve command queue
     context.queue = context.device.getQueue();
     if (!context.queue) {
         std::cerr << "Failed to retrieve command queue." << std::endl;
+        return false;
     }
+    return true;
+}
+
+void releaseWebGPU(WebGPUContext& context) {
+    if (context.profiler.active) {
+        endProfiling(context);
+    }
+    clearPipelineCache(context);
+    for (size_t slot = 0; slot < context.staging.buffers.size(); ++slot) {
+        if (context.staging.inFlight[slot]) {
+            waitForJob(context, context.staging.inFlight[slot]);
+        }
+        if (context.staging.buffers[slot]) {
+            context.counters.buffersLive--;
+            context.counters.bytesLive -= context.staging.capacities[slot];
+            context.staging.buffers[slot].release();
+        }
+    }
+    context.staging.buffers.clear();
+    context.staging.capacities.clear();
+    context.staging.inFlight.clear();
+
+    // Initialization may have stopped part way
+    if (context.queue) {
+        wgpuQueueRelease(context.queue);
+    }
+    if (context.device) {
+        wgpuDeviceRelease(context.device);
+    }
+    if (context.adapter) {
+        wgpuAdapterRelease(context.adapter);
+    }
+    if (context.instance) {
+        wgpuInstanceRelease(context.instance);
+    }
+}
+
+void clearPipelineCache(WebGPUContext& context) {
+    for (auto& entry : context.pipelines) {
+        entry.second.release();
+    }
+    context.pipelines.clear();
+    for (auto& entry : context.shaderModules) {
+        entry.second.release();
+    }
+    context.shaderModules.clear();
 }
 
 // FETCH WORKGROUP LIMITS
@@ -61,8 +136,36 @@ WorkgroupLimits getWorkgroupLimits(wgpu::Device& device) {
     return result;
 }
 
+WorkgroupLimits getWorkgroupShape(wgpu::Device& device, uint32_t requestedX, uint32_t requestedY) {
+    WorkgroupLimits shape = getWorkgroupLimits(device);
+    const double side = std::floor(std::sqrt(shape.maxInvocationsPerWorkgroup));
+    const double x = std::min(shape.maxWorkgroupSizeX, requestedX > 0 ? double(requestedX) : side);
+    const double y = std::min(shape.maxWorkgroupSizeY, requestedY > 0 ? double(requestedY) : side);
+    shape.maxWorkgroupSizeX = std::max(1.0, x);
+    shape.maxWorkgroupSizeY = std::max(1.0, std::min(y, std::floor(shape.maxInvocationsPerWorkgroup / shape.maxWorkgroupSizeX)));
+    return shape;
+}
+
+uint64_t getStorageBufferOffsetAlignment(wgpu::Device& device) {
+    WGPUSupportedLimits limits = {};
+    if (!wgpuDeviceGetLimits(device, &limits) || limits.limits.minStorageBufferOffsetAlignment == 0) {
+        std::cerr << "Error fetching storage buffer offset alignment." << std::endl;
+        return 256; // the WebGPU default limit
+    }
+    return limits.limits.minStorageBufferOffsetAlignment;
+}
+
+uint64_t getUniformBufferOffsetAlignment(wgpu::Device& device) {
+    WGPUSupportedLimits limits = {};
+    if (!wgpuDeviceGetLimits(device, &limits) || limits.limits.minUniformBufferOffsetAlignment == 0) {
+        std::cerr << "Error fetching uniform buffer offset alignment." << std::endl;
+        return 256; // the WebGPU default limit
+    }
+    return limits.limits.minUniformBufferOffsetAlignment;
+}
+
 // LOADING AND COMPILING SHADER CODE
-std::string readShaderFile(const std::string& filename, int workgroupsX, int workgroupsY, int workgroupsZ) {
+std::string readShaderFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Failed to open shader file: " << filename << std::endl;
@@ -70,21 +173,11 @@ std::string readShaderFile(const std::string& filename, int workgroupsX, int wor
     }
     std::stringstream buffer;
     buffer << file.rdbuf();
-    std::string shaderCode = buffer.str();
-
-    // Write the new workgroup sizes
-    std::string workgroups = std::to_string(workgroupsX) + ", " + std::to_string(workgroupsY) + ", " + std::to_string(workgroupsZ);
-    std::string token = "{{WORKGROUP_SIZE}}";
-    auto pos = shaderCode.find(token);
-    if (pos == std::string::npos) {
-        throw std::runtime_error("WGSL template missing WORKGROUP_SIZE token");
-    }
-    shaderCode.replace(pos, token.size(), workgroups);
-
-    return shaderCode;
+    return buffer.str();
 }
 
 wgpu::ShaderModule createShaderModule(wgpu::Device& device, const std::string& shaderCode) {
+    TRACE_SCOPE("shader compile");
     wgpu::ShaderModuleWGSLDescriptor wgslDesc = {};
     wgslDesc.chain.next = nullptr;
     wgslDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
@@ -101,6 +194,20 @@ wgpu::ShaderModule createShaderModule(wgpu::Device& device, const std::string& s
     return shaderModule;
 }
 
+wgpu::ShaderModule getShaderModule(WebGPUContext& context, const std::string& filename, const std::string& prelude) {
+    const std::string key = prelude + filename;
+    auto cached = context.shaderModules.find(key);
+    if (cached != context.shaderModules.end()) {
+        context.counters.shaderCacheHits++;
+        return cached->second;
+    }
+    context.counters.shaderCompiles++;
+
+    wgpu::ShaderModule shaderModule = createShaderModule(context.device, prelude + readShaderFile(filename));
+    context.shaderModules.emplace(key, shaderModule);
+    return shaderModule;
+}
+
 // CREATING BUFFERS
 wgpu::Buffer createBuffer(wgpu::Device& device, const void* data, size_t size, wgpu::BufferUsage usage) {
     wgpu::BufferDescriptor bufferDesc = {};
@@ -120,8 +227,57 @@ wgpu::Buffer createBuffer(wgpu::Device& device, const void* data, size_t size, w
     return buffer;
 }
 
+wgpu::Buffer createBuffer(WebGPUContext& context, const void* data, size_t size, wgpu::BufferUsage usage) {
+    wgpu::Buffer buffer = createBuffer(context.device, nullptr, size, usage);
+    if (buffer) {
+        context.counters.buffersCreated++;
+        context.counters.bytesAllocated += size;
+        context.counters.buffersLive++;
+        context.counters.bytesLive += size;
+    }
+    if (buffer && data) {
+        writeBuffer(context, buffer, 0, data, size);
+    }
+    return buffer;
+}
+
+void releaseBuffer(WebGPUContext& context, wgpu::Buffer& buffer) {
+    if (!buffer) {
+        return;
+    }
+    context.counters.buffersLive--;
+    context.counters.bytesLive -= buffer.getSize();
+    buffer.release();
+    buffer = nullptr;
+}
+
+void writeBuffer(WebGPUContext& context, wgpu::Buffer& buffer, uint64_t offset, const void* data, size_t size) {
+    context.counters.uploads++;
+    context.counters.bytesUploaded += size;
+    context.queue.writeBuffer(buffer, offset, data, size);
+}
+
+void submitCommandBuffer(WebGPUContext& context, wgpu::CommandBuffer& commandBuffer) {
+    TRACE_SCOPE("queue submit");
+    context.counters.submits++;
+    context.queue.submit(1, &commandBuffer);
+}
+
+void resetCounters(WebGPUContext& context) {
+    RuntimeCounters reset;
+    reset.buffersLive = context.counters.buffersLive;
+    reset.bytesLive = context.counters.bytesLive;
+    context.counters = reset;
+}
+
 // COMPUTE PIPELINE UTILITIES
-wgpu::ComputePipeline createComputePipeline(wgpu::Device& device, wgpu::ShaderModule shaderModule, wgpu::BindGroupLayout bindGroupLayout) {
+wgpu::ComputePipeline createComputePipeline(
+    wgpu::Device& device,
+    wgpu::ShaderModule shaderModule,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const std::vector<PipelineConstant>& constants
+) {
+    TRACE_SCOPE("pipeline create");
     // Define pipeline layout
     wgpu::PipelineLayoutDescriptor pipelineLayoutDesc = {};
     pipelineLayoutDesc.bindGroupLayoutCount = 1;
@@ -138,6 +294,15 @@ wgpu::ComputePipeline createComputePipeline(wgpu::Device& device, wgpu::ShaderMo
     computeStage.module = shaderModule;
     computeStage.entryPoint = "main";
 
+    // Override constants specialize the module without recompiling the WGSL
+    std::vector<wgpu::ConstantEntry> constantEntries(constants.size());
+    for (size_t index = 0; index < constants.size(); ++index) {
+        constantEntries[index].key = constants[index].key.c_str();
+        constantEntries[index].value = constants[index].value;
+    }
+    computeStage.constantCount = constantEntries.size();
+    computeStage.constants = constantEntries.data();
+
     // Define compute pipeline
     wgpu::ComputePipelineDescriptor pipelineDesc = {};
     pipelineDesc.layout = pipelineLayout;
@@ -147,23 +312,75 @@ wgpu::ComputePipeline createComputePipeline(wgpu::Device& device, wgpu::ShaderMo
     if (!pipeline) {
         std::cerr << "Failed to create compute pipeline." << std::endl;
     }
+    pipelineLayout.release();
 
     return pipeline;
 }
 
+wgpu::ComputePipeline getComputePipeline(
+    WebGPUContext& context,
+    const std::string& filename,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const std::vector<PipelineConstant>& constants,
+    const std::string& prelude
+) {
+    std::ostringstream key;
+    key.precision(17);
+    key << prelude << filename;
+    for (const PipelineConstant& constant : constants) {
+        key << "|" << constant.key << "=" << constant.value;
+    }
+
+    auto cached = context.pipelines.find(key.str());
+    if (cached != context.pipelines.end()) {
+        context.counters.pipelineCacheHits++;
+        return cached->second;
+    }
+    context.counters.pipelineCompiles++;
+
+    TRACE_SCOPE("plan pipeline");
+    wgpu::ShaderModule shaderModule = getShaderModule(context, filename, prelude);
+    wgpu::ComputePipeline pipeline = createComputePipeline(context.device, shaderModule, bindGroupLayout, constants);
+    context.pipelines.emplace(key.str(), pipeline);
+    return pipeline;
+}
+
 // CREATE COMMAND BUFFER
-wgpu::CommandBuffer createComputeCommandBuffer(
+// Claims the next begin/end query pair for `pass`; returns false when not profiling or out of queries
+static bool reserveTimestampPair(WebGPUContext& context, const PassInfo& pass, uint32_t& firstQuery) {
+    GpuProfiler& profiler = context.profiler;
+    if (!profiler.active) {
+        return false;
+    }
+    if (profiler.passes.size() >= profiler.capacity) {
+        if (profiler.passes.size() == profiler.capacity) {
+            std::cerr << "Profiler is full; later passes are not timed." << std::endl;
+            profiler.passes.push_back({});
+        }
+        return false;
+    }
+    if (profiler.passes.empty()) {
+        profiler.firstPassHost = std::chrono::steady_clock::now();
+    }
+    firstQuery = uint32_t(2 * profiler.passes.size());
+    profiler.passes.push_back(pass);
+    return true;
+}
+
+static wgpu::CommandBuffer encodeComputePass(
     wgpu::Device& device,
     wgpu::ComputePipeline& computePipeline,
     wgpu::BindGroup& bindGroup,
     uint32_t workgroupsX,
     uint32_t workgroupsY,
-    uint32_t workgroupsZ
+    uint32_t workgroupsZ,
+    const WGPUComputePassTimestampWrites* timestampWrites
 ) {
     wgpu::CommandEncoderDescriptor encoderDesc = {};
     wgpu::CommandEncoder commandEncoder = device.createCommandEncoder(encoderDesc);
 
     wgpu::ComputePassDescriptor computePassDesc = {};
+    computePassDesc.timestampWrites = timestampWrites;
     wgpu::ComputePassEncoder computePass = commandEncoder.beginComputePass(computePassDesc);
     computePass.setPipeline(computePipeline);
     computePass.setBindGroup(0, bindGroup, 0, nullptr);
@@ -174,47 +391,228 @@ wgpu::CommandBuffer createComputeCommandBuffer(
     return commandEncoder.finish(cmdBufferDesc);
 }
 
+wgpu::CommandBuffer createComputeCommandBuffer(
+    wgpu::Device& device,
+    wgpu::ComputePipeline& computePipeline,
+    wgpu::BindGroup& bindGroup,
+    uint32_t workgroupsX,
+    uint32_t workgroupsY,
+    uint32_t workgroupsZ
+) {
+    return encodeComputePass(device, computePipeline, bindGroup, workgroupsX, workgroupsY, workgroupsZ, nullptr);
+}
+
+wgpu::CommandBuffer createComputeCommandBuffer(
+    WebGPUContext& context,
+    const PassInfo& pass,
+    wgpu::ComputePipeline& computePipeline,
+    wgpu::BindGroup& bindGroup,
+    uint32_t workgroupsX,
+    uint32_t workgroupsY,
+    uint32_t workgroupsZ
+) {
+    context.counters.dispatches++;
+    uint32_t firstQuery = 0;
+    if (!reserveTimestampPair(context, pass, firstQuery)) {
+        return encodeComputePass(context.device, computePipeline, bindGroup, workgroupsX, workgroupsY, workgroupsZ, nullptr);
+    }
+    WGPUComputePassTimestampWrites timestampWrites = {};
+    timestampWrites.querySet = context.profiler.querySet;
+    timestampWrites.beginningOfPassWriteIndex = firstQuery;
+    timestampWrites.endOfPassWriteIndex = firstQuery + 1;
+    return encodeComputePass(context.device, computePipeline, bindGroup, workgroupsX, workgroupsY, workgroupsZ, &timestampWrites);
+}
+
+// Core WebGPU only timestamps pass boundaries, so a profiled copy is bracketed by two empty
+// compute passes: the end of the first and the beginning of the second
+static void writeEmptyPassTimestamp(WebGPUContext& context, wgpu::CommandEncoder& encoder, uint32_t beginIndex, uint32_t endIndex) {
+    WGPUComputePassTimestampWrites timestampWrites = {};
+    timestampWrites.querySet = context.profiler.querySet;
+    timestampWrites.beginningOfPassWriteIndex = beginIndex;
+    timestampWrites.endOfPassWriteIndex = endIndex;
+
+    wgpu::ComputePassDescriptor computePassDesc = {};
+    computePassDesc.timestampWrites = &timestampWrites;
+    wgpu::ComputePassEncoder computePass = encoder.beginComputePass(computePassDesc);
+    computePass.end();
+    computePass.release();
+}
+
+void encodeBufferCopy(
+    WebGPUContext& context,
+    wgpu::CommandEncoder& encoder,
+    const std::string& label,
+    wgpu::Buffer& source,
+    wgpu::Buffer& destination,
+    uint64_t size
+) {
+    uint32_t firstQuery = 0;
+    const bool timed = reserveTimestampPair(context, {label, 2.0 * double(size), 0.0}, firstQuery);
+    if (timed) {
+        writeEmptyPassTimestamp(context, encoder, WGPU_QUERY_SET_INDEX_UNDEFINED, firstQuery);
+    }
+    encoder.copyBufferToBuffer(source, 0, destination, 0, size);
+    if (timed) {
+        writeEmptyPassTimestamp(context, encoder, firstQuery + 1, WGPU_QUERY_SET_INDEX_UNDEFINED);
+    }
+}
+
 // READBACK RESULTS FROM GPU TO CPU
-std::vector<float> readBack(wgpu::Device& device, wgpu::Queue& queue, size_t buffer_len, wgpu::Buffer& outputBuffer) {
-    std::vector<float> output(buffer_len);
+void reserveStagingSlots(WebGPUContext& context, size_t count) {
+    StagingRing& ring = context.staging;
+    if (ring.buffers.size() >= count) {
+        return;
+    }
+    // New slots start empty and are sized on first use
+    ring.buffers.resize(count, nullptr);
+    ring.capacities.resize(count, 0);
+    ring.inFlight.resize(count);
+}
 
-    wgpu::BufferDescriptor readbackBufferDesc = {};
-    readbackBufferDesc.size = buffer_len * sizeof(float);
-    readbackBufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
-    wgpu::Buffer readbackBuffer = device.createBuffer(readbackBufferDesc);
+// Returns the next slot in the staging ring, first waiting out any asynchronous readback still
+// using it. The slot's buffer is reallocated only when it is too small for this readback or
+// more than twice the size of the largest recent one.
+static size_t acquireStagingSlot(WebGPUContext& context, size_t bytes) {
+    StagingRing& ring = context.staging;
+    if (ring.buffers.empty()) {
+        reserveStagingSlots(context, StagingRing::defaultSlotCount);
+    }
+    ring.recentSizes[ring.nextHistory] = bytes;
+    ring.nextHistory = (ring.nextHistory + 1) % StagingRing::historyLength;
+    const size_t target = *std::max_element(ring.recentSizes.begin(), ring.recentSizes.end());
+
+    const size_t slot = ring.nextSlot;
+    ring.nextSlot = (slot + 1) % ring.buffers.size();
+    if (ring.inFlight[slot]) {
+        waitForJob(context, ring.inFlight[slot]);
+        ring.inFlight[slot] = nullptr;
+    }
+    wgpu::Buffer& buffer = ring.buffers[slot];
+    if (buffer && ring.capacities[slot] >= bytes && ring.capacities[slot] <= 2 * target) {
+        return slot;
+    }
 
-    wgpu::CommandEncoderDescriptor encoderDesc = {};
-    wgpu::CommandEncoder copyEncoder = device.createCommandEncoder(encoderDesc);
-    copyEncoder.copyBufferToBuffer(outputBuffer, 0, readbackBuffer, 0, buffer_len * sizeof(float));
+    if (buffer) {
+        context.counters.buffersLive--;
+        context.counters.bytesLive -= ring.capacities[slot];
+        buffer.destroy();
+        buffer.release();
+    }
+    wgpu::BufferDescriptor stagingDesc = {};
+    stagingDesc.size = target;
+    stagingDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    buffer = context.device.createBuffer(stagingDesc);
+    if (!buffer) {
+        std::cerr << "Failed to create staging buffer." << std::endl;
+    }
+    ring.capacities[slot] = buffer ? target : 0;
+    if (buffer) {
+        context.counters.buffersCreated++;
+        context.counters.bytesAllocated += target;
+        context.counters.buffersLive++;
+        context.counters.bytesLive += target;
+    }
+    return slot;
+}
+
+struct StagingMapRequest {
+    bool complete = false;
+    WGPUBufferMapAsyncStatus status = WGPUBufferMapAsyncStatus_Unknown;
+};
+
+// Plain C callback so mapping does not heap-allocate a std::function per readback
+static void onStagingMapped(WGPUBufferMapAsyncStatus status, void* userdata) {
+    StagingMapRequest* request = static_cast<StagingMapRequest*>(userdata);
+    request->status = status;
+    request->complete = true;
+}
 
+// Encodes and submits the copy of `bytes` of outputBuffer into `staging`
+static void submitStagingCopy(WebGPUContext& context, wgpu::Buffer& outputBuffer, wgpu::Buffer& staging, size_t bytes) {
+    // Command buffers are single-use in WebGPU, so the copy is re-encoded per readback
+    wgpu::CommandEncoderDescriptor encoderDesc = {};
+    wgpu::CommandEncoder copyEncoder = context.device.createCommandEncoder(encoderDesc);
+    encodeBufferCopy(context, copyEncoder, "readback copy", outputBuffer, staging, bytes);
     wgpu::CommandBuffer commandBuffer = copyEncoder.finish();
-    queue.submit(1, &commandBuffer);
+    submitCommandBuffer(context, commandBuffer);
+    context.counters.readBacks++;
+    context.counters.bytesDownloaded += bytes;
+    commandBuffer.release();
+    copyEncoder.release();
+}
+
+// Copies `bytes` of outputBuffer into `staging` and maps it for reading.
+// Returns the mapped range, or nullptr (after printing the reason); the caller unmaps on success.
+static const void* stageReadback(WebGPUContext& context, wgpu::Buffer& outputBuffer, size_t bytes, wgpu::Buffer& staging) {
+    staging = context.staging.buffers[acquireStagingSlot(context, bytes)];
+    if (!staging) {
+        return nullptr;
+    }
+
+    submitStagingCopy(context, outputBuffer, staging, bytes);
 
     //MAPPING BACK TO CPU
-    bool mappingComplete = false;
-    auto handle = readbackBuffer.mapAsync(wgpu::MapMode::Read, 0, buffer_len * sizeof(float), [&](wgpu::BufferMapAsyncStatus status) {
-        if (status == wgpu::BufferMapAsyncStatus::Success) {
-            void* mappedData = readbackBuffer.getMappedRange(0, buffer_len * sizeof(float));
-            if (mappedData) {
-                memcpy(output.data(), mappedData, buffer_len * sizeof(float));
-                readbackBuffer.unmap();
-            } else {
-                std::cerr << "Failed to get mapped range!" << std::endl;
-            }
-        } else {
-            std::cerr << "Failed to map buffer! Status: " << int(status) << std::endl;
+    StagingMapRequest request;
+    wgpuBufferMapAsync(staging, WGPUMapMode_Read, 0, bytes, onStagingMapped, &request);
+
+    // Block until the copy has finished and the mapping callback has fired
+    {
+        TRACE_SCOPE("readback map wait");
+        while (!request.complete) {
+            wgpuDevicePoll(context.device, true, nullptr);
         }
-        mappingComplete = true;
-    });
+    }
 
-    // Wait for the mapping to complete
-    while (!mappingComplete) {
-        wgpuDevicePoll(device, false, nullptr); 
+    if (request.status != WGPUBufferMapAsyncStatus_Success) {
+        std::cerr << "Failed to map buffer! Status: " << int(request.status) << std::endl;
+        return nullptr;
+    }
+    const void* mappedData = staging.getConstMappedRange(0, bytes);
+    if (!mappedData) {
+        std::cerr << "Failed to get mapped range!" << std::endl;
+        staging.unmap();
     }
+    return mappedData;
+}
 
-    readbackBuffer.release();
-    commandBuffer.release();
+bool readBackMapped(
+    WebGPUContext& context,
+    size_t bytes,
+    wgpu::Buffer& outputBuffer,
+    const std::function<void(const void* data, size_t size)>& consumer
+) {
+    wgpu::Buffer staging = nullptr;
+    const void* mappedData = stageReadback(context, outputBuffer, bytes, staging);
+    if (!mappedData) {
+        return false;
+    }
+    consumer(mappedData, bytes);
+    staging.unmap();
+    return true;
+}
 
+bool readBackInto(WebGPUContext& context, wgpu::Buffer& outputBuffer, float* destination, size_t buffer_len) {
+    return readBackMapped(context, buffer_len * sizeof(float), outputBuffer, [&](const void* data, size_t size) {
+        memcpy(destination, data, size);
+    });
+}
+
+std::vector<float> readBack(WebGPUContext& context, size_t buffer_len, wgpu::Buffer& outputBuffer) {
+    std::vector<float> output(buffer_len);
+    if (!readBackInto(context, outputBuffer, output.data(), buffer_len)) {
+        output.clear();
+    }
+    return output;
+}
+
+std::vector<uint16_t> readBackHalf(WebGPUContext& context, size_t buffer_len, wgpu::Buffer& outputBuffer) {
+    std::vector<uint16_t> output(buffer_len);
+    const bool mapped = readBackMapped(context, buffer_len * sizeof(uint16_t), outputBuffer, [&](const void* data, size_t size) {
+        memcpy(output.data(), data, size);
+    });
+    if (!mapped) {
+        output.clear();
+    }
     return output;
 }
 
@@ -227,7 +625,153 @@ void waitForQueueIdle(wgpu::Device& device, wgpu::Queue& queue) {
         workDone = true;
     });
 
+    // A waiting poll sleeps until the queue drains instead of spinning a core
     while (!workDone) {
-        wgpuDevicePoll(device, false, nullptr);
+        wgpuDevicePoll(device, true, nullptr);
+    }
+}
+
+// GPU TIMESTAMP PROFILING
+bool beginProfiling(WebGPUContext& context, uint32_t maxPasses) {
+    GpuProfiler& profiler = context.profiler;
+    if (!context.supportsTimestamps) {
+        std::cerr << "Timestamp queries are not supported by this adapter; profiling is unavailable." << std::endl;
+        return false;
+    }
+    if (profiler.active) {
+        endProfiling(context);
+    }
+
+    wgpu::QuerySetDescriptor querySetDesc = {};
+    querySetDesc.type = wgpu::QueryType::Timestamp;
+    querySetDesc.count = 2 * maxPasses;
+    profiler.querySet = context.device.createQuerySet(querySetDesc);
+    profiler.resolveBuffer = createBuffer(context, nullptr, sizeof(uint64_t) * 2 * maxPasses,
+        WGPUBufferUsage(wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc));
+    if (!profiler.querySet || !profiler.resolveBuffer) {
+        std::cerr << "Failed to create timestamp query set." << std::endl;
+        return false;
+    }
+    profiler.capacity = maxPasses;
+    profiler.passes.clear();
+    profiler.active = true;
+    return true;
+}
+
+std::vector<PassTiming> endProfiling(WebGPUContext& context) {
+    GpuProfiler& profiler = context.profiler;
+    std::vector<PassTiming> timings;
+    if (!profiler.active) {
+        return timings;
+    }
+    // Stop recording first so the resolve and readback below are not profiled themselves
+    profiler.active = false;
+
+    const uint32_t passes = uint32_t(std::min<size_t>(profiler.passes.size(), profiler.capacity));
+    if (passes > 0) {
+        wgpu::CommandEncoder encoder = context.device.createCommandEncoder();
+        encoder.resolveQuerySet(profiler.querySet, 0, 2 * passes, profiler.resolveBuffer, 0);
+        wgpu::CommandBuffer commandBuffer = encoder.finish();
+        submitCommandBuffer(context, commandBuffer);
+        commandBuffer.release();
+        encoder.release();
+
+        // wgpu-native exposes no timestamp period; resolved values are treated as nanoseconds
+        readBackMapped(context, sizeof(uint64_t) * 2 * passes, profiler.resolveBuffer, [&](const void* data, size_t) {
+            const uint64_t* ticks = static_cast<const uint64_t*>(data);
+            for (uint32_t pass = 0; pass < passes; ++pass) {
+                const uint64_t begin = ticks[2 * pass];
+                const uint64_t end = ticks[2 * pass + 1];
+                const double startMs = begin > ticks[0] ? double(begin - ticks[0]) * 1e-6 : 0.0;
+                timings.push_back({profiler.passes[pass], end > begin ? double(end - begin) * 1e-6 : 0.0, startMs});
+            }
+        });
+        traceGpuPasses(timings, profiler.firstPassHost);
+    }
+
+    profiler.querySet.release();
+    profiler.querySet = nullptr;
+    releaseBuffer(context, profiler.resolveBuffer);
+    profiler.passes.clear();
+    profiler.capacity = 0;
+    return timings;
+}
+
+// ASYNCHRONOUS COMPLETION
+// Callbacks receive a heap-allocated reference to the job so its state outlives a caller
+// that drops the handle before the GPU finishes
+static void onFenceDone(WGPUQueueWorkDoneStatus status, void* userdata) {
+    AsyncJob* job = static_cast<AsyncJob*>(userdata);
+    if (status != WGPUQueueWorkDoneStatus_Success) {
+        std::cerr << "Queue completion failed with status: " << int(status) << std::endl;
+    }
+    (*job)->succeeded = status == WGPUQueueWorkDoneStatus_Success;
+    (*job)->completedAt = std::chrono::steady_clock::now();
+    (*job)->complete = true;
+    delete job;
+}
+
+static void onReadbackMapped(WGPUBufferMapAsyncStatus status, void* userdata) {
+    AsyncJob* job = static_cast<AsyncJob*>(userdata);
+    AsyncJobState& state = **job;
+    if (status == WGPUBufferMapAsyncStatus_Success) {
+        const void* mappedData = state.staging.getConstMappedRange(0, state.bytes);
+        if (mappedData) {
+            memcpy(state.destination, mappedData, state.bytes);
+            state.succeeded = true;
+        } else {
+            std::cerr << "Failed to get mapped range!" << std::endl;
+        }
+        state.staging.unmap();
+    } else {
+        std::cerr << "Failed to map buffer! Status: " << int(status) << std::endl;
+    }
+    state.completedAt = std::chrono::steady_clock::now();
+    state.complete = true;
+    delete job;
+}
+
+bool pollAsync(WebGPUContext& context) {
+    return wgpuDevicePoll(context.device, false, nullptr);
+}
+
+AsyncJob submitFence(WebGPUContext& context) {
+    AsyncJob job = std::make_shared<AsyncJobState>();
+    wgpuQueueOnSubmittedWorkDone(context.queue, onFenceDone, new AsyncJob(job));
+    return job;
+}
+
+AsyncJob readBackAsync(WebGPUContext& context, wgpu::Buffer& outputBuffer, void* destination, size_t bytes) {
+    AsyncJob job = std::make_shared<AsyncJobState>();
+    job->destination = destination;
+    job->bytes = bytes;
+
+    const size_t slot = acquireStagingSlot(context, bytes);
+    job->staging = context.staging.buffers[slot];
+    if (!job->staging) {
+        job->completedAt = std::chrono::steady_clock::now();
+        job->complete = true;
+        return job;
+    }
+    context.staging.inFlight[slot] = job;
+
+    submitStagingCopy(context, outputBuffer, job->staging, bytes);
+    wgpuBufferMapAsync(job->staging, WGPUMapMode_Read, 0, bytes, onReadbackMapped, new AsyncJob(job));
+    return job;
+}
+
+bool waitForJob(WebGPUContext& context, const AsyncJob& job) {
+    TRACE_SCOPE("job wait");
+    while (!job->complete) {
+        wgpuDevicePoll(context.device, true, nullptr);
+    }
+    return job->succeeded;
+}
+
+bool waitForJobs(WebGPUContext& context, const std::vector<AsyncJob>& jobs) {
+    bool succeeded = true;
+    for (const AsyncJob& job : jobs) {
+        succeeded = waitForJob(context, job) && succeeded;
     }
+    return succeeded;
 }
@@ -4,14 +4,145 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <map>
+#include <string>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <array>
+#include <memory>
+#include <chrono>
+
+// Completion state for GPU work submitted without waiting. Jobs complete from inside device
+// polls, so drive them with pollAsync, waitForJob or waitForJobs.
+struct AsyncJobState {
+    bool complete = false;
+    bool succeeded = false;
+    // When the completion callback fired (observed during a device poll)
+    std::chrono::steady_clock::time_point completedAt;
+
+    // Readback jobs: the staging buffer being mapped and the caller-owned destination
+    wgpu::Buffer staging = nullptr;
+    void* destination = nullptr;
+    size_t bytes = 0;
+};
+using AsyncJob = std::shared_ptr<AsyncJobState>;
+
+// Reusable MapRead staging buffers for readbacks. Each slot is reallocated only when it is
+// smaller than a request or far larger than any recent readback, so steady-state downloads
+// of the same transform size create no buffers.
+struct StagingRing {
+    static constexpr size_t defaultSlotCount = 2;
+    static constexpr size_t historyLength = 8;
+
+    std::vector<wgpu::Buffer> buffers;
+    std::vector<size_t> capacities;
+    size_t nextSlot = 0;
+    // Asynchronous readback still mapping each slot, if any; a slot is reused only once it completes
+    std::vector<AsyncJob> inFlight;
+
+    // Byte sizes of the most recent readbacks, used to shrink after a one-off large transform
+    std::array<size_t, historyLength> recentSizes = {};
+    size_t nextHistory = 0;
+};
+
+// Label and modeled cost of one pass, for profiling: compulsory global-memory traffic and
+// arithmetic (0 when the pass does none)
+struct PassInfo {
+    std::string label;
+    double bytes = 0.0;
+    double flops = 0.0;
+};
+
+// GPU duration of one profiled pass or copy, and its start relative to the first profiled pass
+struct PassTiming {
+    PassInfo pass;
+    double milliseconds;
+    double startMs = 0.0;
+};
+
+// Achievable global-memory bandwidth of a device, measured once by measureDeviceBandwidth
+struct DeviceBandwidth {
+    bool measured = false;
+    double copyGBs = 0.0;   // copyBufferToBuffer
+    double kernelGBs = 0.0; // streaming read/write compute kernel
+};
+
+// Timestamp-query recorder used between beginProfiling and endProfiling. Every compute pass
+// and profiled copy takes a consecutive begin/end query pair recorded under a label.
+struct GpuProfiler {
+    bool active = false;
+    wgpu::QuerySet querySet = nullptr;
+    wgpu::Buffer resolveBuffer = nullptr;
+    uint32_t capacity = 0; // query pairs
+    std::vector<PassInfo> passes;
+    // Host time the first pass was encoded, anchoring GPU passes on the host timeline in traces
+    std::chrono::steady_clock::time_point firstPassHost;
+};
+
+// Running totals of GPU API use on a context, for telling why a transform got slow.
+// Buffer figures cover buffers created and released through the context helpers and the staging ring.
+struct RuntimeCounters {
+    uint64_t buffersCreated = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t buffersLive = 0;
+    uint64_t bytesLive = 0;
+    uint64_t shaderCompiles = 0; // shader-module cache misses
+    uint64_t shaderCacheHits = 0;
+    uint64_t pipelineCompiles = 0; // pipeline cache misses
+    uint64_t pipelineCacheHits = 0;
+    uint64_t dispatches = 0;
+    uint64_t submits = 0;
+    uint64_t uploads = 0; // writeBuffer calls
+    uint64_t bytesUploaded = 0;
+    uint64_t readBacks = 0;
+    uint64_t bytesDownloaded = 0;
+};
+
+// Fastest engine and workgroup shape found by tuneTransform for one adapter and shape
+struct TunedPlan {
+    bool useDft = false;
+    uint32_t workgroupX = 0;
+    uint32_t workgroupY = 0;
+    double milliseconds = 0.0; // median of the tuning runs
+};
 
 struct WebGPUContext {
     wgpu::Instance instance = nullptr;
     wgpu::Adapter adapter = nullptr;
     wgpu::Device device = nullptr;
     wgpu::Queue queue = nullptr;
+    std::string adapterName;
+
+    // Whether the device was created with the shader-f16 feature
+    bool supportsF16 = false;
+    // Whether the device was created with the timestamp-query feature
+    bool supportsTimestamps = false;
+
+    // Shader modules keyed by WGSL prelude and file, compiled once per context
+    std::map<std::string, wgpu::ShaderModule> shaderModules;
+    // Pipelines keyed by WGSL prelude, file and override constants
+    std::map<std::string, wgpu::ComputePipeline> pipelines;
+
+    // Staging buffers shared by all readbacks on this context
+    StagingRing staging;
+
+    // Per-pass GPU timing, recording only while active
+    GpuProfiler profiler;
+    // Peak bandwidth reference for per-pass roofline reports
+    DeviceBandwidth bandwidth;
+
+    // API usage since initWebGPU or the last resetCounters
+    RuntimeCounters counters;
+
+    // Tuned plans keyed by adapter, shape and storage, consulted by fft() at plan time
+    std::map<std::string, TunedPlan> wisdom;
+};
+
+// Value for a WGSL `override` declaration, applied at pipeline creation
+struct PipelineConstant {
+    std::string key;
+    double value;
 };
 
 struct WorkgroupLimits {
@@ -21,13 +152,30 @@ struct WorkgroupLimits {
     double maxInvocationsPerWorkgroup;
 };
 
-// Initializes WebGPU
-void initWebGPU(WebGPUContext& context);
+// Initializes WebGPU; returns false (after printing the reason) when no adapter, device or queue is available
+bool initWebGPU(WebGPUContext& context);
+
+// Creates the device and queue for an adapter already held in context.adapter (with its instance in
+// context.instance); initWebGPU ends here, and multi-device setups call it once per adapter
+bool initWebGPUDevice(WebGPUContext& context);
+
+// Releases cached shader modules and pipelines along with the device handles
+void releaseWebGPU(WebGPUContext& context);
 
 WorkgroupLimits getWorkgroupLimits(wgpu::Device& device);
 
+// Device limits with maxWorkgroupSizeX/Y replaced by the workgroup shape the transform passes use:
+// the requested shape clamped to the device limits, or sqrt(maxInvocationsPerWorkgroup) square when 0
+WorkgroupLimits getWorkgroupShape(wgpu::Device& device, uint32_t requestedX, uint32_t requestedY);
+
+// Required alignment, in bytes, of storage-buffer binding offsets
+uint64_t getStorageBufferOffsetAlignment(wgpu::Device& device);
+
+// Required alignment, in bytes, of uniform-buffer binding offsets
+uint64_t getUniformBufferOffsetAlignment(wgpu::Device& device);
+
 // Reads shader source code from a file
-std::string readShaderFile(const std::string& filename, int workgroupsX = 256, int workgroupsY = 1, int workgroupsZ = 1);
+std::string readShaderFile(const std::string& filename);
 
 // Creates a WebGPU shader module from WGSL source code
 wgpu::ShaderModule createShaderModule(wgpu::Device& device, const std::string& shaderCode);
@@ -35,8 +183,44 @@ wgpu::ShaderModule createShaderModule(wgpu::Device& device, const std::string& s
 // Creates a WebGPU buffer
 wgpu::Buffer createBuffer(wgpu::Device& device, const void* data, size_t size, wgpu::BufferUsage usage);
 
+// Creates a buffer counted in context.counters; release it with releaseBuffer
+wgpu::Buffer createBuffer(WebGPUContext& context, const void* data, size_t size, wgpu::BufferUsage usage);
+
+// Releases a buffer created with the context overload of createBuffer
+void releaseBuffer(WebGPUContext& context, wgpu::Buffer& buffer);
+
+// Queues an upload of `size` bytes at `offset`, counted in context.counters
+void writeBuffer(WebGPUContext& context, wgpu::Buffer& buffer, uint64_t offset, const void* data, size_t size);
+
+// Submits one command buffer to the context's queue, counted in context.counters
+void submitCommandBuffer(WebGPUContext& context, wgpu::CommandBuffer& commandBuffer);
+
+// Zeroes the counters except the live-buffer figures, which describe current state
+void resetCounters(WebGPUContext& context);
+
+// Returns the shader module for a WGSL file, compiling it on first use.
+// The prelude is prepended to the source (e.g. `enable` directives and type aliases).
+wgpu::ShaderModule getShaderModule(WebGPUContext& context, const std::string& filename, const std::string& prelude = "");
+
+// Releases every cached shader module and pipeline, so the next transform starts cold
+void clearPipelineCache(WebGPUContext& context);
+
 // Compute pipeline utilities
-wgpu::ComputePipeline createComputePipeline(wgpu::Device& device, wgpu::ShaderModule shaderModule, wgpu::BindGroupLayout bindGroupLayout);
+wgpu::ComputePipeline createComputePipeline(
+    wgpu::Device& device,
+    wgpu::ShaderModule shaderModule,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const std::vector<PipelineConstant>& constants = {}
+);
+
+// Specializes a cached shader module with override constants; pipelines are owned by the context
+wgpu::ComputePipeline getComputePipeline(
+    WebGPUContext& context,
+    const std::string& filename,
+    wgpu::BindGroupLayout bindGroupLayout,
+    const std::vector<PipelineConstant>& constants,
+    const std::string& prelude = ""
+);
 
 // Create command buffer
 wgpu::CommandBuffer createComputeCommandBuffer(
@@ -48,10 +232,74 @@ wgpu::CommandBuffer createComputeCommandBuffer(
     uint32_t workgroupsZ = 1
 );
 
-// Readback from GPU to CPU
-std::vector<float> readBack(wgpu::Device& device, wgpu::Queue& queue, size_t buffer_len, wgpu::Buffer& outputBuffer);
+// Grows the staging ring to at least `count` slots, allowing that many asynchronous readbacks in flight
+void reserveStagingSlots(WebGPUContext& context, size_t count);
+
+// Create command buffer for one compute pass, timed under `pass` while profiling
+wgpu::CommandBuffer createComputeCommandBuffer(
+    WebGPUContext& context,
+    const PassInfo& pass,
+    wgpu::ComputePipeline& computePipeline,
+    wgpu::BindGroup& bindGroup,
+    uint32_t workgroupsX,
+    uint32_t workgroupsY = 1,
+    uint32_t workgroupsZ = 1
+);
+
+// Records a buffer-to-buffer copy into `encoder`, timed under `label` (reading and writing `size` bytes) while profiling
+void encodeBufferCopy(
+    WebGPUContext& context,
+    wgpu::CommandEncoder& encoder,
+    const std::string& label,
+    wgpu::Buffer& source,
+    wgpu::Buffer& destination,
+    uint64_t size
+);
+
+// Readback from GPU to CPU; empty if the staging buffer could not be mapped
+std::vector<float> readBack(WebGPUContext& context, size_t buffer_len, wgpu::Buffer& outputBuffer);
+
+// Readback into caller-owned memory (buffer_len floats); does no device or host allocation
+// once the staging ring has grown to the transform size. Returns false, leaving `destination`
+// untouched, when the staging buffer could not be mapped.
+bool readBackInto(WebGPUContext& context, wgpu::Buffer& outputBuffer, float* destination, size_t buffer_len);
+
+// Readback that hands the mapped staging range to `consumer` before unmapping, avoiding a host copy.
+// Returns false, without calling `consumer`, when the staging buffer could not be mapped.
+bool readBackMapped(
+    WebGPUContext& context,
+    size_t bytes,
+    wgpu::Buffer& outputBuffer,
+    const std::function<void(const void* data, size_t size)>& consumer
+);
+
+// Readback of a buffer holding IEEE half floats (buffer_len halves); empty on failure
+std::vector<uint16_t> readBackHalf(WebGPUContext& context, size_t buffer_len, wgpu::Buffer& outputBuffer);
 
 // Wait until all previously submitted GPU work has completed -- need for exhaustive benchmarking tests
 void waitForQueueIdle(wgpu::Device& device, wgpu::Queue& queue);
 
+// GPU TIMESTAMP PROFILING
+// Starts recording up to `maxPasses` passes; returns false when the device lacks timestamp queries
+bool beginProfiling(WebGPUContext& context, uint32_t maxPasses = 4096);
+
+// Stops recording, resolves the queries and returns each pass's GPU duration in submission order
+std::vector<PassTiming> endProfiling(WebGPUContext& context);
+
+// ASYNCHRONOUS COMPLETION
+// Fires callbacks for work that has already finished without blocking; returns true once the queue is empty
+bool pollAsync(WebGPUContext& context);
+
+// Job that completes once everything submitted to the queue so far has finished on the GPU
+AsyncJob submitFence(WebGPUContext& context);
+
+// Starts copying `bytes` of outputBuffer into `destination`, which must stay valid until the job completes
+AsyncJob readBackAsync(WebGPUContext& context, wgpu::Buffer& outputBuffer, void* destination, size_t bytes);
+
+// Blocks in the driver (rather than spinning) until the job completes; returns whether it succeeded
+bool waitForJob(WebGPUContext& context, const AsyncJob& job);
+
+// Blocks until every job completes; returns whether all of them succeeded
+bool waitForJobs(WebGPUContext& context, const std::vector<AsyncJob>& jobs);
+
 #endif
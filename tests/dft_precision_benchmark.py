@@ -0,0 +1,82 @@
+import csv
+import os
+import subprocess
+
+import numpy as np
+
+from precision_test import INPUT_FILE, build_wgpu, compare_results, generate_input_file, run_wgpu
+
+# benchmarking params: non-power-of-2 sizes plus the 8192^2 case from the README
+DIMENSIONS = [500, 1000, 3000, 6000, 8192]
+PRECISIONS = ["standard", "compensated"]
+REPEATS = 3
+
+# output artifacts
+OUTPUT_DIR = "tests/artifacts"
+CSV_FILE = f"{OUTPUT_DIR}/dft_precision_results.csv"
+
+
+def measure_accuracy(np_input, dft_precision):
+    wgpu_forward, _ = run_wgpu(force_dft=True, dft_precision=dft_precision)
+    np_forward = np.fft.fft2(np_input).astype(np.complex64)
+    mismatches, offender = compare_results(wgpu_forward, np_forward)
+    max_rel_err = offender["rel_err"] if offender is not None else 0.0
+    return int(mismatches), max_rel_err
+
+
+def measure_runtime(dft_precision, repeats):
+    command = [
+        "build/wgpu_dft",
+        f"--input={INPUT_FILE}",
+        "--force-dft",
+        f"--dft-precision={dft_precision}",
+        "--mode=forward",
+        f"--benchmark={repeats}",
+    ]
+    result = subprocess.run(
+        command,
+        check=True,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.DEVNULL,
+        universal_newlines=True,
+    )
+    for line in result.stdout.splitlines():
+        parts = line.split()
+        if parts and parts[0] == "mean_ms":
+            return float(parts[1])
+    raise RuntimeError("benchmark output missing mean_ms")
+
+
+def write_csv(rows):
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    with open(CSV_FILE, "w", newline="") as handle:
+        writer = csv.writer(handle)
+        writer.writerow(["dimension", "dft_precision", "forward_mismatches", "max_rel_err", "mean_ms"])
+        writer.writerows(rows)
+
+
+def main():
+    print("Building WGPU project...")
+    build_wgpu()
+
+    rows = []
+    for dimension in DIMENSIONS:
+        np_input = generate_input_file(INPUT_FILE, dimension, dimension)
+        baseline_ms = None
+        for dft_precision in PRECISIONS:
+            print(f"Running: {dimension}x{dimension} | DFT {dft_precision}")
+            mismatches, max_rel_err = measure_accuracy(np_input, dft_precision)
+            mean_ms = measure_runtime(dft_precision, REPEATS)
+            baseline_ms = baseline_ms or mean_ms
+            print(
+                f"mismatches={mismatches} | max_rel_err={max_rel_err:.3e} "
+                f"| mean_ms={mean_ms:.3f} ({mean_ms / baseline_ms:.2f}x standard)"
+            )
+            rows.append([dimension, dft_precision, mismatches, f"{max_rel_err:.6e}", f"{mean_ms:.6f}"])
+
+    write_csv(rows)
+    print(f"Results saved to {CSV_FILE}")
+
+
+if __name__ == "__main__":
+    main()
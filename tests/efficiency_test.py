@@ -19,18 +19,15 @@ CSV_FILE = f"{OUTPUT_DIR}/efficiency_results.csv"
 RAW_CSV_FILE = f"{OUTPUT_DIR}/efficiency_raw_results.csv"
 FORWARD_PLOT = f"{OUTPUT_DIR}/efficiency_forward.png"
 BACKWARD_PLOT = f"{OUTPUT_DIR}/efficiency_backward.png"
+INPUT_FILE = f"{OUTPUT_DIR}/input.npy"
 
 
 def generate_input_file(path, dimension):
     real = np.random.rand(dimension, dimension).astype(np.float32)
     imag = np.random.rand(dimension, dimension).astype(np.float32)
-    values = real + 1j * imag
-
-    with open(path, "w") as handle:
-        handle.write(f"{dimension} {dimension}\n")
-        for row in values:
-            entries = [f"{value.real} {value.imag}" for value in row]
-            handle.write(" ".join(entries) + "\n")
+    values = (real + 1j * imag).astype(np.complex64)
+    np.save(path, values)
+    return values
 
 
 def build_wgpu():
@@ -47,7 +44,7 @@ def build_wgpu():
 
 
 def run_transform(force_dft, mode):
-    command = ["build/wgpu_dft", f"--mode={mode}"]
+    command = ["build/wgpu_dft", f"--input={INPUT_FILE}", f"--mode={mode}", f"--output={OUTPUT_DIR}/output.npy"]
     if force_dft:
         command.append("--force-dft")
 
@@ -79,7 +76,7 @@ def parse_benchmark_output(output):
 
 
 def benchmark_pass(force_dft, mode, repeats):
-    command = ["build/wgpu_dft", f"--mode={mode}", f"--benchmark={repeats}"]
+    command = ["build/wgpu_dft", f"--input={INPUT_FILE}", f"--mode={mode}", f"--benchmark={repeats}"]
     if force_dft:
         command.append("--force-dft")
 
@@ -115,10 +112,7 @@ def benchmark_cupy_pass(values, direction, repeats):
 
 
 def benchmark_dimension(dimension, repeats):
-    input_path = "tests/artifacts/input.txt"
-    generate_input_file(input_path, dimension)
-    values = np.loadtxt(input_path, skiprows=1, dtype=np.float32).reshape(dimension, dimension, 2)
-    np_input = values[:, :, 0] + 1j * values[:, :, 1]
+    np_input = generate_input_file(INPUT_FILE, dimension)
 
     results = {"DFT": {}, "FFT": {}, "CuPy": {}}
     for algorithm, force_dft in [("DFT", True), ("FFT", False)]:
@@ -141,10 +135,7 @@ def benchmark_dimension(dimension, repeats):
 
 def run_warmup():
     for dimension in WARMUP_DIMENSIONS:
-        input_path = "tests/artifacts/input.txt"
-        generate_input_file(input_path, dimension)
-        values = np.loadtxt(input_path, skiprows=1, dtype=np.float32).reshape(dimension, dimension, 2)
-        np_input = values[:, :, 0] + 1j * values[:, :, 1]
+        np_input = generate_input_file(INPUT_FILE, dimension)
         for algorithm, force_dft in [("DFT", True), ("FFT", False)]:
             for direction in ["forward", "backward"]:
                 print(f"Warmup: {dimension}x{dimension} | {algorithm} | {direction}")
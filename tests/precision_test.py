@@ -1,10 +1,19 @@
 import numpy as np
+import pytest
+import socket
 import subprocess
 from pathlib import Path
 
 ROWS, COLS = 512, 512
 TOLERANCE = 1e-4
 PYTEST_TOLERANCE = 1e-2
+# f16 storage keeps ~3 significant digits, so compare with an absolute floor
+# near the output magnitude of an ortho-normalized transform
+F16_TOLERANCE = 1e-2
+
+# data is exchanged with wgpu_dft as complex64 .npy files
+INPUT_FILE = "tests/artifacts/input.npy"
+OUTPUT_FILE = "tests/artifacts/output.npy"
 
 def generate_input_file(filename, rows=512, cols=512):
     Path(filename).parent.mkdir(parents=True, exist_ok=True)
@@ -12,6 +21,10 @@ def generate_input_file(filename, rows=512, cols=512):
     imag = np.random.rand(rows, cols).astype(np.float32)
     input_complex = real + 1j * imag
 
+    if filename.endswith(".npy"):
+        np.save(filename, input_complex.astype(np.complex64))
+        return input_complex
+
     # write matrix to txt file for wgpu to read in
     with open(filename, 'w') as f:
         f.write(f"{rows} {cols}\n")
@@ -22,14 +35,48 @@ def generate_input_file(filename, rows=512, cols=512):
             f.write(" ".join(row_data) + "\n")
     return input_complex
 
+def write_binary_input(filename, values):
+    # raw matrix format read by --input: 32-byte little-endian header, then complex64 data
+    rows, cols = values.shape
+    header = np.array([rows, cols, 1, 1, 0, 0], dtype="<u4")
+    with open(filename, "wb") as f:
+        f.write(b"WDFT")
+        f.write(np.array([1], dtype="<u4").tobytes())
+        f.write(header.tobytes())
+        f.write(np.ascontiguousarray(values, dtype="<c8").tobytes())
+
 def build_wgpu():
     subprocess.run(["cmake", "-B", "build", "-S", "."], check=True, stdout=subprocess.DEVNULL)
     subprocess.run(["cmake", "--build", "build"], check=True, stdout=subprocess.DEVNULL)
 
-def run_wgpu(force_dft=False):
-    command = ["./build/wgpu_dft"]
+def run_wgpu(
+    force_dft=False,
+    norm="backward",
+    storage="f32",
+    dft_precision="standard",
+    input_path=INPUT_FILE,
+    output_path=OUTPUT_FILE,
+    row_blocks=0,
+    cpu=False,
+    in_place=False,
+):
+    command = [
+        "./build/wgpu_dft",
+        f"--input={input_path}",
+        f"--norm={norm}",
+        f"--storage={storage}",
+        f"--dft-precision={dft_precision}",
+    ]
+    if output_path is not None:
+        command.append(f"--output={output_path}")
     if force_dft:
         command.append("--force-dft")
+    if row_blocks > 0:
+        command.append(f"--row-blocks={row_blocks}")
+    if cpu:
+        command.append("--cpu")
+    if in_place:
+        command.append("--in-place")
 
     result = subprocess.run(
         command,
@@ -37,7 +84,12 @@ def run_wgpu(force_dft=False):
         stdout=subprocess.PIPE,
         universal_newlines=True,
     )
-    return result.stdout
+    if output_path is None:
+        return parse_wgpu_output(result.stdout)
+
+    # (2, rows, cols): forward then inverse
+    output = np.load(output_path)
+    return output[0], output[1]
 
 def parse_wgpu_output(output):
     lines = output.strip().splitlines()
@@ -59,8 +111,8 @@ def parse_wgpu_output(output):
             iresult[i, j] = re + 1j * im
     return result, iresult
 
-def compare_results(wgpu_result, numpy_result, rel_tol=TOLERANCE):
-    is_close = np.isclose(wgpu_result, numpy_result, rtol=rel_tol, atol=1e-4)
+def compare_results(wgpu_result, numpy_result, rel_tol=TOLERANCE, abs_tol=1e-4):
+    is_close = np.isclose(wgpu_result, numpy_result, rtol=rel_tol, atol=abs_tol)
     mismatches = np.sum(~is_close)
     offender = None
     for row, col in np.argwhere(~is_close):
@@ -108,22 +160,21 @@ def print_summary(mismatches, offender):
     print(f"wgpu : {offender['actual']}")
     print(f"numpy: {offender['expected']}")
 
-def run_mode(force_dft, np_input, rel_tol=TOLERANCE):
-    np_forward = np.fft.fft2(np_input).astype(np.complex64)
-    np_inverse = np.fft.ifft2(np_input).astype(np.complex64)
+def run_mode(force_dft, np_input, rel_tol=TOLERANCE, norm="backward", storage="f32", abs_tol=1e-4, dft_precision="standard", cpu=False):
+    np_forward = np.fft.fft2(np_input, norm=norm).astype(np.complex64)
+    np_inverse = np.fft.ifft2(np_input, norm=norm).astype(np.complex64)
 
-    output = run_wgpu(force_dft=force_dft)
-    wgpu_forward, wgpu_inverse = parse_wgpu_output(output)
+    wgpu_forward, wgpu_inverse = run_wgpu(force_dft=force_dft, norm=norm, storage=storage, dft_precision=dft_precision, cpu=cpu)
 
-    forward_mismatches, forward_offender = compare_results(wgpu_forward, np_forward, rel_tol=rel_tol)
-    inverse_mismatches, inverse_offender = compare_results(wgpu_inverse, np_inverse, rel_tol=rel_tol)
+    forward_mismatches, forward_offender = compare_results(wgpu_forward, np_forward, rel_tol=rel_tol, abs_tol=abs_tol)
+    inverse_mismatches, inverse_offender = compare_results(wgpu_inverse, np_inverse, rel_tol=rel_tol, abs_tol=abs_tol)
     return {
         "forward": (forward_mismatches, forward_offender),
         "backward": (inverse_mismatches, inverse_offender),
     }
 
-def report_mode(title, force_dft, np_input):
-    results = run_mode(force_dft=force_dft, np_input=np_input)
+def report_mode(title, force_dft, np_input, norm="backward", storage="f32", cpu=False):
+    results = run_mode(force_dft=force_dft, np_input=np_input, norm=norm, storage=storage, cpu=cpu)
 
     print_section(title)
     print_subsection("Forward")
@@ -134,10 +185,253 @@ def report_mode(title, force_dft, np_input):
 # for pytest
 def test_precision_512x512_rel_tol_1e_2():
     build_wgpu()
-    np_input = generate_input_file("tests/artifacts/input.txt", ROWS, COLS)
+    np_input = generate_input_file(INPUT_FILE, ROWS, COLS)
 
-    for title, force_dft in [("DFT", True), ("FFT", False)]:
-        results = run_mode(force_dft=force_dft, np_input=np_input, rel_tol=PYTEST_TOLERANCE)
+    for title, force_dft, cpu in [("DFT", True, False), ("FFT", False, False), ("CPU", False, True)]:
+        results = run_mode(force_dft=force_dft, np_input=np_input, rel_tol=PYTEST_TOLERANCE, cpu=cpu)
+        for direction in ["forward", "backward"]:
+            mismatches, offender = results[direction]
+            assert mismatches == 0, (
+                f"{title} {direction} exceeded rel_tol={PYTEST_TOLERANCE}: "
+                f"mismatches={mismatches}, offender={offender}"
+            )
+
+def test_precision_normalization_modes():
+    build_wgpu()
+    np_input = generate_input_file(INPUT_FILE, 64, 64)
+
+    for norm in ["ortho", "forward"]:
+        for title, force_dft, cpu in [("DFT", True, False), ("FFT", False, False), ("CPU", False, True)]:
+            results = run_mode(force_dft=force_dft, np_input=np_input, rel_tol=PYTEST_TOLERANCE, norm=norm, cpu=cpu)
+            for direction in ["forward", "backward"]:
+                mismatches, offender = results[direction]
+                assert mismatches == 0, (
+                    f"{title} {direction} norm={norm} exceeded rel_tol={PYTEST_TOLERANCE}: "
+                    f"mismatches={mismatches}, offender={offender}"
+                )
+
+def test_input_and_output_formats_agree():
+    build_wgpu()
+    np_input = generate_input_file("tests/artifacts/input.txt", 64, 48)
+    write_binary_input("tests/artifacts/input.bin", np_input.astype(np.complex64))
+    np.save(INPUT_FILE, np_input.astype(np.complex64))
+
+    for force_dft in [True, False]:
+        text_output = run_wgpu(force_dft=force_dft, input_path="tests/artifacts/input.txt", output_path=None)
+        for input_path in ["tests/artifacts/input.bin", INPUT_FILE]:
+            for output_path in [None, OUTPUT_FILE]:
+                output = run_wgpu(force_dft=force_dft, input_path=input_path, output_path=output_path)
+                for text_result, result in zip(text_output, output):
+                    if output_path is None:
+                        assert np.array_equal(text_result, result)
+                    else:
+                        # printed text is rounded to 6 significant digits
+                        assert np.allclose(text_result, result, rtol=1e-5, atol=1e-5)
+
+# uploading in row blocks only changes when each row pass starts, not its result
+def test_row_block_upload_matches_whole_upload():
+    build_wgpu()
+    for rows, cols in [(64, 48), (64, 64)]:
+        np_input = generate_input_file(INPUT_FILE, rows, cols)
+        for force_dft in [True, False]:
+            whole = run_wgpu(force_dft=force_dft)
+            blocked = run_wgpu(force_dft=force_dft, row_blocks=5)
+            for whole_result, blocked_result in zip(whole, blocked):
+                assert np.array_equal(whole_result, blocked_result)
+
+        mismatches, offender = compare_results(blocked[0], np.fft.fft2(np_input).astype(np.complex64), rel_tol=PYTEST_TOLERANCE)
+        assert mismatches == 0, f"row-block FFT {rows}x{cols}: mismatches={mismatches}, offender={offender}"
+
+# the in-place passes (FFT directly, DFT through row-block and column-tile scratch) match the usual path
+def test_in_place_matches_out_of_place():
+    build_wgpu()
+    # 32x33 and 3x64 are odd-width or short enough that a whole tile used to cover the matrix
+    for rows, cols in [(64, 48), (64, 64), (100, 36), (32, 33), (3, 64)]:
+        np_input = generate_input_file(INPUT_FILE, rows, cols)
+        for force_dft in [True, False]:
+            regular = run_wgpu(force_dft=force_dft)
+            in_place = run_wgpu(force_dft=force_dft, in_place=True)
+            for regular_result, in_place_result in zip(regular, in_place):
+                mismatches, offender = compare_results(in_place_result, regular_result, rel_tol=PYTEST_TOLERANCE)
+                assert mismatches == 0, f"in-place {rows}x{cols} force_dft={force_dft}: mismatches={mismatches}, offender={offender}"
+
+        mismatches, offender = compare_results(in_place[0], np.fft.fft2(np_input).astype(np.complex64), rel_tol=PYTEST_TOLERANCE)
+        assert mismatches == 0, f"in-place FFT {rows}x{cols}: mismatches={mismatches}, offender={offender}"
+
+    # a power-of-two vector runs in place on the FFT passes; a dense DFT of one has no in-place form
+    np_input = generate_input_file(INPUT_FILE, 1, 64)
+    in_place = run_wgpu(in_place=True)
+    mismatches, offender = compare_results(in_place[0], np.fft.fft2(np_input).astype(np.complex64), rel_tol=PYTEST_TOLERANCE)
+    assert mismatches == 0, f"in-place FFT 1x64: mismatches={mismatches}, offender={offender}"
+    with pytest.raises(subprocess.CalledProcessError):
+        run_wgpu(force_dft=True, in_place=True)
+
+# --counters reports the uploads and readbacks the CLI actually performed
+def test_runtime_counters():
+    build_wgpu()
+    rows, cols = 64, 48
+    generate_input_file(INPUT_FILE, rows, cols)
+    result = subprocess.run(
+        ["./build/wgpu_dft", f"--input={INPUT_FILE}", f"--output={OUTPUT_FILE}", "--counters"],
+        check=True,
+        stdout=subprocess.PIPE,
+        universal_newlines=True,
+    )
+    lines = result.stdout.strip().splitlines()
+    counters = dict(line.split() for line in lines[lines.index("counters") + 1:])
+    matrix_bytes = rows * cols * 8
+    assert int(counters["bytes_uploaded"]) == matrix_bytes
+    assert int(counters["readbacks"]) == 2
+    assert int(counters["bytes_downloaded"]) == 2 * matrix_bytes
+    assert int(counters["pipeline_compiles"]) > 0
+    assert int(counters["submits"]) >= int(counters["dispatches"])
+
+# a tuned plan may switch engine and workgroup shape, but not the result
+def test_tuned_plan_from_wisdom_file():
+    build_wgpu()
+    wisdom = Path("tests/artifacts/wisdom.txt")
+    wisdom.unlink(missing_ok=True)
+    for rows, cols in [(64, 64), (48, 40)]:
+        np_input = generate_input_file(INPUT_FILE, rows, cols)
+        subprocess.run(
+            ["./build/wgpu_dft", f"--input={INPUT_FILE}", "--tune=2", f"--wisdom={wisdom}"],
+            check=True,
+            stdout=subprocess.DEVNULL,
+        )
+        fields = [line.split("\t") for line in wisdom.read_text().splitlines()]
+        assert any(field[1:3] == [str(rows), str(cols)] for field in fields)
+
+        command = ["./build/wgpu_dft", f"--input={INPUT_FILE}", f"--output={OUTPUT_FILE}", f"--wisdom={wisdom}"]
+        subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+        forward = np.load(OUTPUT_FILE)[0]
+        mismatches, offender = compare_results(forward, np.fft.fft2(np_input).astype(np.complex64), rel_tol=PYTEST_TOLERANCE)
+        assert mismatches == 0, f"tuned {rows}x{cols}: mismatches={mismatches}, offender={offender}"
+
+# slabs of uneven height, a power-of-2 and a DFT axis, and ortho scaling split over the two passes
+def test_distributed_slabs_match_numpy():
+    build_wgpu()
+    np_input = generate_input_file(INPUT_FILE, 64, 48)
+    command = ["./build/wgpu_dft", f"--input={INPUT_FILE}", f"--output={OUTPUT_FILE}", "--norm=ortho", "--slabs=5", "--all-adapters"]
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+    forward, backward = np.load(OUTPUT_FILE)
+    for title, actual, expected in [
+        ("forward", forward, np.fft.fft2(np_input, norm="ortho")),
+        ("backward", backward, np.fft.ifft2(np_input, norm="ortho")),
+    ]:
+        mismatches, offender = compare_results(actual, expected.astype(np.complex64), rel_tol=PYTEST_TOLERANCE)
+        assert mismatches == 0, f"distributed {title}: mismatches={mismatches}, offender={offender}"
+
+SOCKET_PATH = "tests/artifacts/wgpu_dft.sock"
+JOB_PATH = Path("tests/artifacts/job.bin")
+
+def start_server(*flags):
+    # returns the server process and a connected client with a line reader for its replies
+    server = subprocess.Popen(["./build/wgpu_dft", f"--serve={SOCKET_PATH}", *flags], stdout=subprocess.PIPE, universal_newlines=True)
+    assert server.stdout.readline().split() == ["listening", SOCKET_PATH]
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    client.connect(SOCKET_PATH)
+    return server, client, client.makefile("r")
+
+def stop_server(server, client, replies):
+    client.sendall(b"shutdown\n")
+    assert replies.readline().strip() == "ok"
+    client.close()
+    assert server.wait(timeout=30) == 0
+
+# one server process answers several jobs, of different shapes, through a shared file
+def test_server_jobs_match_numpy():
+    build_wgpu()
+    server, client, replies = start_server()
+    try:
+        for rows, cols, direction in [(64, 48, "forward"), (32, 32, "backward"), (64, 48, "forward")]:
+            np_input = (np.random.rand(rows, cols) + 1j * np.random.rand(rows, cols)).astype(np.complex64)
+            np_input.tofile(JOB_PATH)
+            client.sendall(f"fft {JOB_PATH} {rows} {cols} {direction}\n".encode())
+            assert replies.readline().split()[0] == "ok"
+            actual = np.fromfile(JOB_PATH, dtype=np.complex64).reshape(rows, cols)
+            expected = np.fft.fft2(np_input) if direction == "forward" else np.fft.ifft2(np_input)
+            mismatches, offender = compare_results(actual, expected.astype(np.complex64), rel_tol=PYTEST_TOLERANCE)
+            assert mismatches == 0, f"served {rows}x{cols} {direction}: mismatches={mismatches}, offender={offender}"
+        stop_server(server, client, replies)
+    finally:
+        if server.poll() is None:
+            server.kill()
+
+# a repeated input is answered from the cache with the same result; a new one misses
+def test_server_result_cache():
+    build_wgpu()
+    rows, cols = 64, 48
+    first = (np.random.rand(rows, cols) + 1j * np.random.rand(rows, cols)).astype(np.complex64)
+    second = (np.random.rand(rows, cols) + 1j * np.random.rand(rows, cols)).astype(np.complex64)
+    server, client, replies = start_server("--cache-mb=1")
+    try:
+        results = []
+        for np_input, outcome in [(first, "miss"), (first, "hit"), (second, "miss")]:
+            np_input.tofile(JOB_PATH)
+            client.sendall(f"fft {JOB_PATH} {rows} {cols} forward\n".encode())
+            reply = replies.readline().split()
+            assert reply[0] == "ok" and reply[-1] == outcome
+            results.append(np.fromfile(JOB_PATH, dtype=np.complex64))
+        assert np.array_equal(results[0], results[1])
+        client.sendall(b"stats\n")
+        stats = replies.readline().split()
+        assert stats[1:5] == ["hits", "1", "misses", "2"]
+        stop_server(server, client, replies)
+    finally:
+        if server.poll() is None:
+            server.kill()
+
+# a shape over the device buffer limits is refused and the server keeps serving
+def test_server_rejects_oversized_shape():
+    build_wgpu()
+    server, client, replies = start_server()
+    try:
+        client.sendall(f"fft {JOB_PATH} 1000000 1000000 forward\n".encode())
+        assert replies.readline().split()[0] == "error"
+        client.sendall(b"ping\n")
+        assert replies.readline().strip() == "ok"
+        stop_server(server, client, replies)
+    finally:
+        if server.poll() is None:
+            server.kill()
+
+# a regular file at the socket path is reported, not deleted
+def test_server_keeps_non_socket_path():
+    build_wgpu()
+    path = Path(SOCKET_PATH)
+    path.unlink(missing_ok=True)
+    path.write_text("not a socket")
+    try:
+        result = subprocess.run(["./build/wgpu_dft", f"--serve={SOCKET_PATH}"], stdout=subprocess.DEVNULL)
+        assert result.returncode != 0
+        assert path.read_text() == "not a socket"
+    finally:
+        path.unlink()
+
+# concurrent requests held for a generous window must share dispatches and match a direct transform
+def test_coalesced_requests_match_direct_transform():
+    build_wgpu()
+    for rows, cols in [(64, 64), (64, 48)]:
+        generate_input_file(INPUT_FILE, rows, cols)
+        result = subprocess.run(
+            ["./build/wgpu_dft", f"--input={INPUT_FILE}", "--coalesce=16", "--coalesce-window=20000"],
+            check=True,
+            stdout=subprocess.PIPE,
+            universal_newlines=True,
+        )
+        lines = result.stdout.strip().splitlines()
+        stats = dict(line.split() for line in lines[lines.index("coalesce") + 1:])
+        assert int(stats["requests"]) == 16
+        assert int(stats["batches"]) < 16
+        assert float(stats["max_difference"]) < 1e-3
+
+def test_precision_compensated_dft_non_power_of_two():
+    build_wgpu()
+    np_input = generate_input_file(INPUT_FILE, 300, 500)
+
+    # the CPU engine always accumulates non-power-of-2 lengths in double
+    for title, cpu in [("compensated DFT", False), ("CPU", True)]:
+        results = run_mode(force_dft=not cpu, np_input=np_input, rel_tol=PYTEST_TOLERANCE, dft_precision="compensated", cpu=cpu)
         for direction in ["forward", "backward"]:
             mismatches, offender = results[direction]
             assert mismatches == 0, (
@@ -145,15 +439,42 @@ def test_precision_512x512_rel_tol_1e_2():
                 f"mismatches={mismatches}, offender={offender}"
             )
 
+# f16 storage needs a normalized transform to stay within half range; on
+# adapters without shader-f16 the CLI falls back to f32 and this still passes
+def test_precision_f16_storage():
+    build_wgpu()
+    np_input = generate_input_file(INPUT_FILE, ROWS, COLS)
+
+    for title, force_dft in [("DFT", True), ("FFT", False)]:
+        results = run_mode(
+            force_dft=force_dft,
+            np_input=np_input,
+            rel_tol=F16_TOLERANCE,
+            norm="ortho",
+            storage="f16",
+            abs_tol=F16_TOLERANCE,
+        )
+        for direction in ["forward", "backward"]:
+            mismatches, offender = results[direction]
+            assert mismatches == 0, (
+                f"{title} f16 {direction} exceeded tol={F16_TOLERANCE}: "
+                f"mismatches={mismatches}, offender={offender}"
+            )
+
 def main():
     print("Building WGPU DFT project...")
     build_wgpu()
 
-    np_input = generate_input_file("tests/artifacts/input.txt", ROWS, COLS)
+    np_input = generate_input_file(INPUT_FILE, ROWS, COLS)
     print(f"Input shape: {ROWS}x{COLS}")
 
     report_mode("DFT", force_dft=True, np_input=np_input)
     report_mode("FFT", force_dft=False, np_input=np_input)
+    report_mode("CPU", force_dft=False, np_input=np_input, cpu=True)
+
+    # f16 storage accuracy, compared against numpy with the same ortho normalization
+    report_mode("DFT (f16 storage, ortho)", force_dft=True, np_input=np_input, norm="ortho", storage="f16")
+    report_mode("FFT (f16 storage, ortho)", force_dft=False, np_input=np_input, norm="ortho", storage="f16")
 
 if __name__ == "__main__":
     main()